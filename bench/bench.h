@@ -0,0 +1,48 @@
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+// Corpora checked in under the data root, relative to it.
+inline constexpr auto RAW_SENTENCES = "normalize/corpus.txt";         // as users type them
+inline constexpr auto NORMALIZED_SENTENCES = "normalize/golden.txt";  // as pronounce sees them
+inline constexpr auto NUMBER_SENTENCES = "bench/numbers.txt";         // dense with numbers of every kind
+inline constexpr auto DOCUMENTS = "bench/documents.txt";              // several sentences per line
+
+// The data root, DOGE_BENCH_DATA_ROOT or data/ of the source tree.
+const std::string &data_root();
+
+// The lines of a corpus, read once and kept for the whole run.
+const std::vector<std::string> &corpus(const std::string &name);
+
+// Runs function on one line per iteration, cycling through them, and reports
+// lines and bytes per second. wrap runs untimed whenever the lines start over.
+template <typename F, typename W>
+void for_each_line(benchmark::State &state, const std::vector<std::string> &lines, F &&function, W &&wrap) {
+    size_t index = 0;
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        const auto &line = lines[index];
+        function(line);
+        bytes += line.size();
+        if (++index == lines.size()) {
+            index = 0;
+            state.PauseTiming();
+            wrap();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+
+template <typename F> void for_each_line(benchmark::State &state, const std::vector<std::string> &lines, F &&function) {
+    for_each_line(state, lines, std::forward<F>(function), [] {});
+}
+
+#endif
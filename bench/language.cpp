@@ -0,0 +1,78 @@
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "language/language.h"
+#include "language/normalize.h"
+#include "language/number.h"
+#include "utils/arena.h"
+#include "utils/string.h"
+
+using lisa::language::LanguageHelper;
+
+static void BM_Normalize(benchmark::State &state) {
+    std::string result;
+    for_each_line(state, corpus(RAW_SENTENCES), [&](const std::string &sentence) {
+        lisa::SentenceNormalizer::normalize(sentence, result);
+        benchmark::DoNotOptimize(result.data());
+    });
+}
+BENCHMARK(BM_Normalize);
+
+static void BM_NumberToChinese(benchmark::State &state) {
+    static const auto sentences = [] {
+        std::vector<std::wstring> result;
+        for (const auto &line : corpus(NUMBER_SENTENCES)) {
+            result.push_back(lisa::utils::utf8_to_wstring(line));
+        }
+        return result;
+    }();
+    size_t index = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lisa::NumberHelper::number_to_chinese(sentences[index]));
+        index = index + 1 == sentences.size() ? 0 : index + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NumberToChinese);
+
+static void BM_Tokenize(benchmark::State &state) {
+    const auto &helper = LanguageHelper::instance();
+    helper.ready(LanguageHelper::Component::SEGMENTER).get();
+    for_each_line(state, corpus(NORMALIZED_SENTENCES),
+                  [&](const std::string &sentence) { benchmark::DoNotOptimize(helper.tokenize(sentence)); });
+}
+BENCHMARK(BM_Tokenize);
+
+// An arena per call, or one arena for the run released after every sentence.
+static void BM_Pronounce(benchmark::State &state) {
+    const auto &helper = LanguageHelper::instance();
+    helper.ready().get();
+    const auto shared_arena = state.range(0) != 0;
+    lisa::utils::Arena arena;
+    std::vector<lisa::language::PronounceId> result;
+    for_each_line(state, corpus(NORMALIZED_SENTENCES), [&](const std::string &sentence) {
+        result.clear();
+        helper.pronounce(sentence, result, shared_arena ? arena.resource() : nullptr);
+        arena.release();
+        benchmark::DoNotOptimize(result.data());
+    });
+}
+BENCHMARK(BM_Pronounce)->ArgName("shared_arena")->Arg(0)->Arg(1);
+
+// The whole corpus per iteration, on up to every worker.
+static void BM_PronounceBatch(benchmark::State &state) {
+    const auto &helper = LanguageHelper::instance();
+    helper.ready().get();
+    const auto &sentences = corpus(NORMALIZED_SENTENCES);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(helper.pronounce_batch(sentences, state.range(0)));
+    }
+    state.SetItemsProcessed(state.iterations() * sentences.size());
+}
+BENCHMARK(BM_PronounceBatch)
+    ->ArgName("workers")
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
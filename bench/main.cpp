@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "spdlog/spdlog.h"
+
+static constexpr auto BENCH_DATA_ROOT_ENV = "DOGE_BENCH_DATA_ROOT";
+static constexpr auto JSON_OUTPUT_PATH = "doge_bench.json";
+
+const std::string &data_root() {
+    static const auto root = [] {
+        const auto *env = getenv(BENCH_DATA_ROOT_ENV);
+        const auto path = env != nullptr ? std::filesystem::path(env)
+                                         : std::filesystem::path(__FILE__).parent_path() / "../data";
+        return std::filesystem::weakly_canonical(std::filesystem::absolute(path)).string();
+    }();
+    return root;
+}
+
+const std::vector<std::string> &corpus(const std::string &name) {
+    static std::mutex mutex;
+    static std::map<std::string, std::vector<std::string>> corpora;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = corpora.find(name);
+    if (iter == corpora.end()) {
+        std::vector<std::string> lines;
+        std::ifstream ifs(data_root() + "/" + name);
+        std::string line;
+        while (std::getline(ifs, line)) {
+            if (!line.empty()) {
+                lines.push_back(line);
+            }
+        }
+        if (lines.empty()) {
+            spdlog::error("Empty or missing corpus: {}/{}", data_root(), name);
+            std::exit(1);
+        }
+        iter = corpora.emplace(name, std::move(lines)).first;
+    }
+    return iter->second;
+}
+
+// FNV-1a over the lines, so results are only compared across builds run on the
+// same inputs.
+static std::string fingerprint(const std::vector<std::string> &lines) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const auto &line : lines) {
+        for (const auto ch : line) {
+            hash = (hash ^ static_cast<uint8_t>(ch)) * 0x100000001b3ULL;
+        }
+        hash = (hash ^ '\n') * 0x100000001b3ULL;
+    }
+    return spdlog::fmt_lib::format("{} lines, fnv1a {:016x}", lines.size(), hash);
+}
+
+// Microbenchmarks of the hot paths, on the corpora under the data root. Results
+// go to the console and, unless --benchmark_out is given, as JSON to
+// doge_bench.json in the working directory, to be compared across builds with
+// compare.py from google benchmark's tools.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::err);
+
+    std::vector<char *> args(argv, argv + argc);
+    std::string out_arg = std::string("--benchmark_out=") + JSON_OUTPUT_PATH;
+    std::string format_arg = "--benchmark_out_format=json";
+    const auto has_out = std::any_of(args.begin() + 1, args.end(),
+                                     [](const char *arg) { return std::string(arg).rfind("--benchmark_out=", 0) == 0; });
+    if (!has_out) {
+        args.push_back(out_arg.data());
+        args.push_back(format_arg.data());
+    }
+    auto count = static_cast<int>(args.size());
+    args.push_back(nullptr);
+
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+        return 1;
+    }
+    benchmark::AddCustomContext("data_root", data_root());
+    for (const auto name : {RAW_SENTENCES, NORMALIZED_SENTENCES, NUMBER_SENTENCES, DOCUMENTS}) {
+        benchmark::AddCustomContext(name, fingerprint(corpus(name)));
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <memory>
+
+#include "bench.h"
+#include "message/audio_message.h"
+#include "message/message_pool.h"
+#include "message/message_queue.h"
+#include "message/text_message.h"
+
+using lisa::message::AudioMessage;
+using lisa::message::MessagePool;
+using lisa::message::MessageQueue;
+
+// Every thread pushes a message and pops one from the same queue, so the lock
+// is contended by all of them.
+static void BM_MessageQueuePushPop(benchmark::State &state) {
+    static MessageQueue queue;
+    const auto msg = std::make_shared<lisa::message::TextMessage>();
+    for (auto _ : state) {
+        queue.push(msg);
+        benchmark::DoNotOptimize(queue.wait());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MessageQueuePushPop)->ThreadRange(1, 16)->UseRealTime();
+
+// Acquires a pooled message and releases it back, the pool never runs dry.
+static void BM_MessagePoolGetRelease(benchmark::State &state) {
+    static MessagePool<AudioMessage> pool(MessagePool<AudioMessage>::MAX_MSG_COUNT);
+    for (auto _ : state) {
+        auto msg = pool.get();
+        benchmark::DoNotOptimize(msg.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MessagePoolGetRelease)->ThreadRange(1, 16)->UseRealTime();
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "language/language.h"
+#include "model/melo/preprocess.h"
+#include "utils/arena.h"
+
+using lisa::model::MeloPreprocessor;
+
+// Fewer sentences than the phoneme cache holds, so a warm run only hits.
+static constexpr size_t PREPROCESS_SENTENCES = 1024;
+
+// Both are cached, cold empties the caches before every pass over the corpus,
+// warm fills them before timing starts.
+static void BM_Split(benchmark::State &state) {
+    const auto cold = state.range(0) != 0;
+    const MeloPreprocessor preprocessor;
+    const auto &documents = corpus(DOCUMENTS);
+    MeloPreprocessor::clear_caches();
+    if (!cold) {
+        for (const auto &document : documents) {
+            preprocessor.split(document);
+        }
+    }
+    for_each_line(
+        state, documents, [&](const std::string &document) { benchmark::DoNotOptimize(preprocessor.split(document)); },
+        [&] {
+            if (cold) {
+                MeloPreprocessor::clear_caches();
+            }
+        });
+}
+BENCHMARK(BM_Split)->ArgName("cold")->Arg(1)->Arg(0);
+
+static void BM_Preprocess(benchmark::State &state) {
+    lisa::language::LanguageHelper::instance().ready().get();
+    const auto cold = state.range(0) != 0;
+    const MeloPreprocessor preprocessor;
+    const auto &sentences = corpus(NORMALIZED_SENTENCES);
+    const std::vector<std::string> subset(sentences.begin(),
+                                          sentences.begin() + std::min(sentences.size(), PREPROCESS_SENTENCES));
+    lisa::utils::Arena arena;
+    MeloPreprocessor::clear_caches();
+    if (!cold) {
+        for (const auto &sentence : subset) {
+            preprocessor.preprocess(sentence);
+        }
+    }
+    for_each_line(
+        state, subset,
+        [&](const std::string &sentence) {
+            benchmark::DoNotOptimize(preprocessor.preprocess(sentence, 1.0f, arena.resource()));
+            arena.release();
+        },
+        [&] {
+            if (cold) {
+                MeloPreprocessor::clear_caches();
+            }
+        });
+}
+BENCHMARK(BM_Preprocess)->ArgName("cold")->Arg(1)->Arg(0);
@@ -3,14 +3,21 @@
 #ifndef INCLUDE_LANGUAGE_LANGUAGE_H_
 #define INCLUDE_LANGUAGE_LANGUAGE_H_
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <future>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <thread>
 #include <vector>
 
-namespace cppjieba {
-class Jieba;
-}
+#include "language/lexicon.h"
+#include "utils/thread_pool.h"
 
 namespace lisa {
 
@@ -28,16 +35,73 @@ struct Pronounce {
     Language lang{};
 };
 
+// Pronounce with the phone interned in SymbolTable::instance().
+struct PronounceId {
+    uint32_t phone{};
+    uint32_t tone{};
+    Language lang{};
+};
+
 using Token = std::pair<std::string, std::string>;
 
 class LanguageHelper final {
 public:
+    // A pinyin syllable without its tone digit, viewing into the lexicon or the token.
+    struct Syllable {
+        std::string_view pinyin{};
+        uint32_t tone{};
+    };
+
+    enum class Component : uint32_t {
+        SEGMENTER = 0, // tokenize
+        LEXICON = 1,   // pronounce, together with the segmenter
+    };
+
+    // Returns as soon as loading has started, the dictionaries load in the background.
     static LanguageHelper &instance();
 
+    // Starts loading without waiting for it, e.g. at boot. The future is ready once
+    // every component is.
+    static std::shared_future<void> preload();
+
+    std::shared_future<void> ready() const { return ready_; }
+    std::shared_future<void> ready(Component component) const;
+
     std::vector<Token> tokenize(const std::string &sentence) const;
 
     std::vector<Pronounce> pronounce(const std::string &sentence) const;
 
+    // Appends to result, no phone is materialized as a string. Every temporary of
+    // the call comes from arena and is left there for the caller to release, e.g.
+    // once per request. Without one the call uses an arena of its own.
+    void pronounce(std::string_view sentence, std::vector<PronounceId> &result,
+                   std::pmr::memory_resource *arena = nullptr) const;
+
+    // Pronounces every sentence on the helper pool plus the calling thread, results
+    // keep the order of sentences. max_workers caps the threads used, 0 for all of
+    // them. Like pronounce, safe to call from several threads at once, but not from
+    // a task running on the helper pool.
+    std::vector<std::vector<PronounceId>> pronounce_batch(const std::vector<std::string> &sentences,
+                                                          size_t max_workers = 0) const;
+
+    // Threads pronounce_batch can use, the pool and the caller.
+    size_t worker_count() const { return pool_->size() + 1; }
+
+    // Content hash of the lexicon pronounce uses right now, it changes with a reload
+    // of edited sources and stays the same on the same ones, wherever they were
+    // copied to. Whatever keeps pronunciations around, like phoneme or audio
+    // caches, is keyed by it.
+    uint64_t lexicon_hash() const;
+
+    // Rebuilds the lexicon from the data root in the background and swaps it in.
+    // Calls in flight finish on the tables they started with and never wait for
+    // a reload. The future holds whether new tables were swapped in.
+    std::shared_future<bool> reload();
+
+    // Reloads the lexicon once a changed text source has been left alone for one
+    // interval, polled every interval. A zero interval stops watching.
+    void watch(std::chrono::milliseconds interval);
+
 private:
     static constexpr auto LANGUAGE_DATA_ROOT_ENV = "DOGE_LANGUAGE_DATA_ROOT";
     static constexpr auto CPPJIEBA_DICT_ROOT_ENV = "DOGE_CPPJIEBA_DICT_ROOT";
@@ -45,50 +109,88 @@ private:
     static constexpr auto LANGUAGE_DATA_DEFAULT_RELATIVE_PATH = "/../../data/language";
     static constexpr auto CPPJIEBA_DICT_DEFAULT_RELATIVE_PATH = "/../../data/cppjieba";
 
-    static constexpr auto UNICODE_PINYIN_FILE_NAME = "unicode.pinyin";
-    static constexpr auto CHINESE_PINYIN_PHONE_MAPPER_FILE_NAME = "chinese_pinyin.phone";
-    static constexpr auto CHINESE_WORDS_PINYIN_MAPPER_FILE_NAME = "chinese_words.pinyin";
-    static constexpr auto TAGGING_WORDS_PINYIN_MAPPER_FILE_NAME = "tagging_words.pinyin";
-    static constexpr auto ENGLISH_WORDS_PINYIN_MAPPER_FILE_NAME = "english_words.pinyin";
-
+    // Only what tagging needs, the keyword extractor dictionaries (idf, stop words) are never loaded.
     static constexpr const char *CPPJIEBA_DICT_FILE_NAME_LIST[] = {
-        "jieba.dict.utf8", "hmm_model.utf8", "user.dict.utf8", "idf.utf8", "stop_words.utf8",
+        "jieba.dict.utf8",
+        "hmm_model.utf8",
+        "user.dict.utf8",
     };
 
+    // One thread per independent load: hmm model, dict trie and lexicon. Batches
+    // use all cores once loading is done.
+    static constexpr size_t STARTUP_THREAD_COUNT = 3;
+
     static constexpr uint16_t CHINESE_UNICODE_BEGIN = 0x4E00;
     static constexpr uint16_t CHINESE_UNICODE_END = 0x9FA5;
+    static constexpr char PRINTABLE_ASCII_BEGIN = ' ';
+    static constexpr char PRINTABLE_ASCII_END = '~';
 
 private:
+    struct Segmenter;
+
+    // Views into the sentence, or into the arena for text the segmenter made.
+    using TokenView = std::pair<std::string_view, std::string_view>;
+    // Allocates from the arena the call was given.
+    using TokenList = std::pmr::vector<TokenView>;
+
+    // The lexicon and what is derived from it, never modified once published.
+    struct LexiconSnapshot {
+        std::unique_ptr<Lexicon> lexicon{};
+        std::vector<uint32_t> symbol_ids{};     // lexicon symbol index to SymbolTable id
+        std::array<uint32_t, 0x80> ascii_ids{}; // printable ASCII character to SymbolTable id
+        uint64_t fingerprint{};                 // of the text sources, polled to reload
+    };
+
     std::string cppjieba_dict_root_{};
-    static std::unique_ptr<cppjieba::Jieba> jieba_;
+    static std::unique_ptr<Segmenter> segmenter_;
 
     std::string language_data_root_{};
-    std::vector<std::string> unicode_pinyin_list_{};
-    std::unordered_map<std::string, std::string> chinese_pinyin_phone_mapper_{};
-    std::unordered_map<std::string, std::string> chinese_words_pinyin_mapper_{};
-    std::unordered_map<std::string, std::string> tagging_words_pinyin_mapper_{};
-    std::unordered_map<std::string, std::string> english_words_pinyin_mapper_{};
+    // Only read and replaced with std::atomic_load and std::atomic_store.
+    std::shared_ptr<const LexiconSnapshot> lexicon_{};
+    std::mutex reload_mutex_{};
+
+    std::mutex watch_mutex_{};
+    std::condition_variable watch_cv_{};
+    std::chrono::milliseconds watch_interval_{0};
+    bool watch_stopping_{false};
+    std::thread watcher_{};
+
+    std::shared_future<void> segmenter_ready_{};
+    std::shared_future<void> lexicon_ready_{};
+    std::shared_future<void> ready_{};
+    // Last, so it is joined before anything its tasks write to goes away.
+    std::unique_ptr<lisa::utils::ThreadPool> pool_{};
 
     LanguageHelper();
+    ~LanguageHelper();
     LanguageHelper(const LanguageHelper &) = delete;
     LanguageHelper &operator=(const LanguageHelper &) = delete;
 
 private:
-    std::vector<std::string> chinese_pinyin(const Token &word) const;
-    std::vector<std::string> english_pinyin(const Token &word) const;
+    // Tags the sentence, cppjieba only sees the spans with non ASCII text in them.
+    void segment(std::string_view sentence, TokenList &result) const;
+
+    void tokenize(std::string_view sentence, TokenList &result) const;
+
+    std::shared_ptr<const LexiconSnapshot> lexicon() const;
+
+    void pronounce(const LexiconSnapshot &lexicon, std::string_view sentence, std::vector<PronounceId> &result,
+                   std::pmr::memory_resource *arena) const;
+
+    void chinese_pinyin(const LexiconSnapshot &lexicon, const TokenView &word, std::pmr::vector<Syllable> &result) const;
+    std::optional<LexiconValue> english_pinyin(const LexiconSnapshot &lexicon, const TokenView &word) const;
 
-    std::vector<Pronounce> chinese_pronounce(const std::string &pinyin) const;
-    std::vector<Pronounce> english_pronounce(const std::string &pinyin) const;
+    void chinese_pronounce(const LexiconSnapshot &lexicon, const Syllable &syllable,
+                           std::vector<PronounceId> &result) const;
+    void english_pronounce(const LexiconSnapshot &lexicon, const LexiconValue &value, size_t index,
+                           std::vector<PronounceId> &result) const;
 
     void get_jieba_dict_root();
-    void initialize_jieba();
+    std::shared_future<void> initialize_jieba();
 
     void get_language_data_root();
-    void get_unicode_pinyin_list();
-    void get_chinese_pinyin_phone_mapper();
-    void get_chinese_words_pinyin_mapper();
-    void get_tagging_words_pinyin_mapper();
-    void get_english_words_pinyin_mapper();
+    std::shared_ptr<const LexiconSnapshot> load_lexicon() const;
+    void watch_sources();
 };
 
 } // namespace language
@@ -0,0 +1,182 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_LANGUAGE_LEXICON_H_
+#define INCLUDE_LANGUAGE_LEXICON_H_
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lisa {
+
+namespace language {
+
+enum class LexiconTable : uint32_t {
+    UNICODE_PINYIN = 0,
+    CHINESE_PINYIN_PHONE = 1,
+    CHINESE_WORDS_PINYIN = 2,
+    TAGGING_WORDS_PINYIN = 3,
+    ENGLISH_WORDS_PINYIN = 4,
+    COUNT = 5,
+};
+
+// A phone of a dictionary value, symbol indexes Lexicon::symbol(). English phones
+// carry their stress as tone (digit + 1, 0 when unstressed), chinese ones 0.
+struct LexiconPhone {
+    uint32_t symbol;
+    uint32_t tone;
+};
+
+// A dictionary value, already split into its items (pinyin syllables, phones,
+// english syllables) when the image was built. Items of the phone tables also
+// come with their phones resolved to symbols.
+class LexiconValue {
+public:
+    static constexpr size_t ITEM_FIELDS = 4; // pool offset, size, first phone, phone count
+
+    LexiconValue(const char *pool, const uint32_t *items, uint32_t count, const LexiconPhone *phones)
+        : pool_(pool), items_(items), count_(count), phones_(phones) {}
+
+    size_t size() const { return count_; }
+
+    std::string_view operator[](size_t index) const {
+        const auto item = items_ + index * ITEM_FIELDS;
+        return std::string_view(pool_ + item[0], item[1]);
+    }
+
+    std::pair<const LexiconPhone *, const LexiconPhone *> phones(size_t index) const {
+        const auto item = items_ + index * ITEM_FIELDS;
+        return {phones_ + item[2], phones_ + item[2] + item[3]};
+    }
+
+private:
+    const char *pool_{};
+    const uint32_t *items_{};
+    uint32_t count_{};
+    const LexiconPhone *phones_{};
+};
+
+// Read-only view over the language dictionaries compiled into one binary image:
+// a header, one entry table and one open addressing hash index per dictionary,
+// the pre-split value items, their phones, the phone symbols and a shared string
+// pool. The image is either mapped
+// from disk or compiled in memory from the text sources, lookups work in place
+// on both and never allocate.
+class Lexicon final {
+public:
+    static constexpr uint32_t MAGIC = 0x4C474F44; // "DOGL"
+    static constexpr uint32_t VERSION = 4;
+
+    static constexpr auto IMAGE_FILE_NAME = "language.lexicon";
+
+    static constexpr const char *SOURCE_FILE_NAME_LIST[] = {
+        "unicode.pinyin", "chinese_pinyin.phone", "chinese_words.pinyin", "tagging_words.pinyin", "english_words.pinyin",
+    };
+
+    ~Lexicon();
+
+    // Maps the compiled image under data_root, nullptr if it is missing, of another
+    // version or out of date with the text sources next to it.
+    static std::unique_ptr<Lexicon> load(const std::string &data_root);
+
+    // Parses the text sources under data_root into an in memory image.
+    static std::unique_ptr<Lexicon> compile(const std::string &data_root);
+
+    static bool save(const std::string &data_root, const std::string &image_path);
+
+    // Changes with the size or modification time of any text source, 0 if one is
+    // missing. Cheap enough to poll, it only tells when to reload.
+    static uint64_t fingerprint(const std::string &data_root);
+
+    // Of the text sources the tables were built from.
+    uint64_t fingerprint() const { return header().fingerprint; }
+
+    // Of the contents of those text sources, hashed once when the image is built.
+    // Copies and checkouts of the same sources keep it.
+    uint64_t content_hash() const { return header().content_hash; }
+
+    size_t size(LexiconTable table) const;
+
+    std::string_view key(LexiconTable table, size_t index) const;
+
+    std::string_view value(LexiconTable table, size_t index) const;
+
+    // Distinct phone names of the phone tables, in the order LexiconPhone::symbol refers to them.
+    size_t symbol_count() const { return header().symbol_count; }
+
+    std::string_view symbol(size_t index) const;
+
+    std::optional<LexiconValue> find(LexiconTable table, std::string_view key, bool ignore_case = false) const {
+        return find(table, &key, 1, ignore_case);
+    }
+
+    // Looks up the concatenation of key_parts without building it.
+    std::optional<LexiconValue> find(LexiconTable table, std::initializer_list<std::string_view> key_parts) const {
+        return find(table, key_parts.begin(), key_parts.size(), false);
+    }
+
+private:
+    struct TableHeader {
+        uint64_t offset;
+        uint64_t count;
+        uint64_t slot_offset;
+        uint64_t slot_count;
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t fingerprint;
+        uint64_t content_hash;
+        uint64_t item_offset;
+        uint64_t item_count;
+        uint64_t phone_offset;
+        uint64_t phone_count;
+        uint64_t symbol_offset;
+        uint64_t symbol_count;
+        uint64_t pool_offset;
+        uint64_t pool_size;
+        TableHeader tables[static_cast<size_t>(LexiconTable::COUNT)];
+    };
+
+    struct Entry {
+        uint32_t key_offset;
+        uint32_t key_size;
+        uint32_t value_offset;
+        uint32_t value_size;
+        uint32_t item_index;
+        uint32_t item_count;
+    };
+
+    Lexicon() = default;
+    Lexicon(const Lexicon &) = delete;
+    Lexicon &operator=(const Lexicon &) = delete;
+
+    static std::vector<uint8_t> build(const std::string &data_root);
+
+    std::optional<LexiconValue> find(LexiconTable table, const std::string_view *parts, size_t count,
+                                     bool ignore_case) const;
+
+    bool validate() const;
+    const Header &header() const { return *reinterpret_cast<const Header *>(data_); }
+    const Entry *entries(LexiconTable table) const;
+    std::string_view pool(uint32_t offset, uint32_t size) const;
+    LexiconValue items(const Entry &entry) const;
+
+private:
+    const uint8_t *data_{};
+    size_t size_{};
+    void *mapping_{};
+    std::vector<uint8_t> buffer_{};
+};
+
+} // namespace language
+
+} // namespace lisa
+
+#endif
@@ -4,43 +4,38 @@
 #define INCLUDE_LANGUAGE_NORMALIZE_H_
 
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
+
+#include "utils/lookup.h"
 
 namespace lisa {
 
+// Rewrites a sentence into what the TTS front end can read: numbers spelled out
+// in chinese, punctuation remapped to ASCII and collapsed, unsupported characters
+// dropped, and spaces added where pronunciation needs the split. All of it is done
+// in a single pass over the UTF-8 input.
 class SentenceNormalizer final {
 public:
-    static std::unordered_set<char> get_supported_punctuations();
-
-    static std::string normalize(const std::string &sentence);
+    static constexpr std::string_view SUPPORTED_PUNCTUATIONS = ",.!?:;";
 
-private:
-    static const std::unordered_set<wchar_t> supported_punctuations_;
-    static const std::unordered_map<wchar_t, wchar_t> punctuation_mapper_;
-
-private:
-    static inline bool is_chinese(wchar_t ch) { return ch >= 0x4E00 && ch <= 0x9FA5; }
+    static constexpr std::string_view get_supported_punctuations() { return SUPPORTED_PUNCTUATIONS; }
 
-    static inline bool is_supported_punctuation(wchar_t ch) {
-        return supported_punctuations_.find(ch) != supported_punctuations_.end();
-    }
+    static constexpr bool is_supported_punctuation(char32_t ch) { return supported_punctuation_set_.contains(ch); }
 
-    static std::wstring replace_number(const std::wstring &sentence);
-
-    static std::wstring remap_punctuation(const std::wstring &sentence);
-
-    static std::wstring remove_unrecognized_chars(const std::wstring &sentence);
+    static std::string normalize(const std::string &sentence);
 
-    static std::wstring remove_continuous_punctuation(const std::wstring &sentence);
+    // Writes into result, which keeps its capacity across calls.
+    static void normalize(std::string_view sentence, std::string &result);
 
-    static std::wstring strip_punctuation_begin_and_end(const std::wstring &sentence);
+private:
+    static constexpr lisa::utils::AsciiSet supported_punctuation_set_{SUPPORTED_PUNCTUATIONS};
 
-    static std::wstring replace_space_between_chinese_and_chinese(const std::wstring &sentence);
+    class Stream;
 
-    static std::wstring append_space_after_inner_punctuation(const std::wstring &sentence);
+private:
+    static inline bool is_chinese(wchar_t ch) { return ch >= 0x4E00 && ch <= 0x9FA5; }
 
-    static std::wstring append_space_between_english_lower_and_upper(const std::wstring &sentence);
+    static inline bool is_separator(wchar_t ch) { return ch == L' ' || is_supported_punctuation(ch); }
 };
 
 } // namespace lisa
@@ -3,9 +3,10 @@
 #ifndef INCLUDE_LANGUAGE_NUMBER_H_
 #define INCLUDE_LANGUAGE_NUMBER_H_
 
+#include <array>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
-#include <vector>
+#include <string_view>
 
 namespace lisa {
 
@@ -13,16 +14,32 @@ class NumberHelper final {
 public:
     static std::wstring number_to_chinese(const std::wstring &sentence);
 
+    // One number as split out of a sentence: optional '-', digits with '.', optional
+    // '%'. Years ("2024年") are read digit by digit. Appends to result, nothing else
+    // is allocated. The integer part must stay below 10^16.
+    static void number_token_to_chinese(std::wstring_view number, bool before_year, std::wstring &result);
+
 private:
-    static const std::unordered_map<wchar_t, wchar_t> number_chinese_mapper_;
+    static constexpr std::array<wchar_t, 10> CHINESE_DIGITS = {
+        L'零', L'一', L'二', L'三', L'四', L'五', L'六', L'七', L'八', L'九',
+    };
+    // Units inside a group of four digits and of the groups themselves.
+    static constexpr std::array<wchar_t, 4> DIGIT_UNITS = {L'\0', L'十', L'百', L'千'};
+    static constexpr std::array<wchar_t, 4> GROUP_UNITS = {L'\0', L'万', L'亿', L'兆'};
+
+    static constexpr size_t GROUP_COUNT = GROUP_UNITS.size();
+    static constexpr size_t GROUP_MAX_LENGTH = 8;                                     // a digit and a unit per digit
+    static constexpr size_t INTEGER_MAX_LENGTH = GROUP_COUNT * (GROUP_MAX_LENGTH + 2); // and a '零' and the unit
 
-    static std::wstring number_to_chinese_directly(const std::wstring &sentence);
+    // End of the number token starting at sentence[begin], begin if none starts there.
+    static size_t number_token_end(std::wstring_view sentence, size_t begin);
 
-    static std::wstring number_to_chinese_complex(uint64_t number);
+    static void number_to_chinese_directly(std::wstring_view digits, std::wstring &result);
 
-    static std::wstring number_to_chinese_complex(const std::wstring &sentence);
+    // Writes the reading of a group below 10000 right to left ending at end, returns its first character.
+    static wchar_t *number_to_chinese_complex(uint64_t number, wchar_t *end);
 
-    static std::vector<std::pair<bool, std::wstring>> split_number_and_other(const std::wstring &sentence);
+    static void number_to_chinese_complex(std::wstring_view digits, std::wstring &result);
 };
 
 } // namespace lisa
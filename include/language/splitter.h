@@ -0,0 +1,84 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_LANGUAGE_SPLITTER_H_
+#define INCLUDE_LANGUAGE_SPLITTER_H_
+
+#include <deque>
+#include <string>
+#include <string_view>
+
+namespace lisa {
+
+namespace language {
+
+// Cuts text arriving piece by piece into normalized chunks of about the same
+// synthesis cost, handed out one at a time. Raw text is cut at sentence ends and
+// normalized a sentence at a time, only as far as the next chunk needs, so a
+// book pushed in pieces is held a few sentences at a time. Clauses are grouped
+// towards the target cost, a clause above the cap is cut between words.
+//
+// A sentence end is only taken once the text after it shows it is one, e.g. a
+// '.' before a digit or after "Dr" is not, so fragments cut anywhere, even
+// inside a character, give the same chunks.
+class StreamSplitter final {
+public:
+    struct Config {
+        size_t target_cost{32};    // estimated phones per chunk
+        size_t max_cost{96};       // no chunk goes above, unless a single word does
+        size_t max_pending{4096};  // raw bytes without a sentence end before one is forced
+        bool eager{false};         // every sentence end closes a chunk, for text still being generated
+    };
+
+    explicit StreamSplitter(const Config &config);
+
+    // Appends raw UTF-8 text, a character may be split across pushes.
+    void push(std::string_view text);
+
+    // No more text follows, the rest can be handed out.
+    void finish();
+
+    // The next chunk, false if the text pushed so far does not complete one.
+    bool next(std::string &chunk);
+
+    // Starts over with no text.
+    void reset();
+
+    // Raw bytes pushed but not yet turned into chunks.
+    size_t pending() const { return raw_.size() - raw_begin_; }
+
+    // Estimated phone count of normalized text: an initial and a final per
+    // chinese character, one per letter or punctuation.
+    static size_t cost(std::string_view text);
+
+private:
+    static constexpr size_t COMPACT_THRESHOLD = 1024;
+
+    // Cuts the next sentence off the raw text, false if more text is needed.
+    bool advance();
+    size_t sentence_end();
+    size_t forced_end() const;
+
+    void add_sentence(std::string_view sentence);
+    void add_clause(std::string_view clause);
+    void group(std::string_view piece, size_t cost);
+    void emit();
+
+private:
+    Config config_{};
+
+    std::string raw_{};
+    size_t raw_begin_{};   // raw_ before it is consumed
+    size_t scan_pos_{};    // raw_ before it holds no sentence end
+    bool finished_{false};
+
+    std::string normalized_{};
+    std::string chunk_{};
+    size_t chunk_cost_{};
+    std::deque<std::string> ready_{};
+};
+
+} // namespace language
+
+} // namespace lisa
+
+#endif
@@ -0,0 +1,48 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_LANGUAGE_SYMBOL_H_
+#define INCLUDE_LANGUAGE_SYMBOL_H_
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace lisa {
+
+namespace language {
+
+// Process wide interning of phone names into dense ids. Ids are never reused and
+// names stay valid for the lifetime of the process, so consumers can map ids with
+// plain arrays built once.
+class SymbolTable final {
+public:
+    static SymbolTable &instance();
+
+    uint32_t intern(std::string_view name);
+
+    std::optional<uint32_t> find(std::string_view name) const;
+
+    std::string_view name(uint32_t id) const;
+
+    size_t size() const;
+
+private:
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+private:
+    mutable std::shared_mutex mutex_{};
+    std::deque<std::string> names_{};
+    std::unordered_map<std::string_view, uint32_t> ids_{};
+};
+
+} // namespace language
+
+} // namespace lisa
+
+#endif
@@ -3,6 +3,7 @@
 #ifndef MESSAGE_AUDIO_MESSAGE_H_
 #define MESSAGE_AUDIO_MESSAGE_H_
 
+#include <memory>
 #include <vector>
 
 #include "message/message.h"
@@ -20,12 +21,23 @@ public:
         Message::reset();
         channels_ = 0;
         sample_rate_ = 0;
+        sequence_ = 0;
         data_.clear();
+        view_.reset();
+        view_size_ = 0;
     }
 
+    const float *samples() const { return view_ ? view_.get() : data_.data(); }
+
+    size_t size() const { return view_ ? view_size_ : data_.size(); }
+
     uint32_t channels_{};
     uint32_t sample_rate_{};
+    uint64_t sequence_{};
     std::vector<float> data_{};
+    // Read-only samples owned elsewhere (e.g. a mapped cache), used instead of data_ when set.
+    std::shared_ptr<const float> view_{};
+    size_t view_size_{};
 };
 
 } // namespace message
@@ -0,0 +1,37 @@
+// cute-giggle@outlook.com
+
+#ifndef MESSAGE_TEXT_MESSAGE_H_
+#define MESSAGE_TEXT_MESSAGE_H_
+
+#include <string>
+
+#include "message/message.h"
+
+namespace lisa {
+
+namespace message {
+
+class TextMessage : public Message {
+public:
+    TextMessage() = default;
+    ~TextMessage() override = default;
+
+    void reset() override {
+        Message::reset();
+        speed_ = 1.0f;
+        text_.clear();
+        partial_ = false;
+    }
+
+    float speed_{1.0f};
+    std::string text_{};
+    // More of the same text follows in later messages, e.g. tokens of a reply
+    // still being generated. The last message of it is not partial.
+    bool partial_{false};
+};
+
+} // namespace message
+
+} // namespace lisa
+
+#endif
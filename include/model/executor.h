@@ -0,0 +1,24 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_MODEL_EXECUTOR_H_
+#define INCLUDE_MODEL_EXECUTOR_H_
+
+#include "model/data.h"
+
+namespace lisa {
+
+namespace model {
+
+class Executor {
+public:
+    virtual ~Executor() = default;
+
+    // Thread safe, may be called concurrently from multiple callers.
+    virtual bool infer(const InputData &input, OutputData &output) = 0;
+};
+
+} // namespace model
+
+} // namespace lisa
+
+#endif
@@ -0,0 +1,83 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_MODEL_MELO_AUDIO_CACHE_H_
+#define INCLUDE_MODEL_MELO_AUDIO_CACHE_H_
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "message/audio_message.h"
+
+namespace lisa {
+
+namespace model {
+
+// On disk cache of synthesized audio. Samples are appended to fixed size,
+// memory mapped segment files and located through an append-only index file,
+// both of which are reloaded on restart. When the cache outgrows max_bytes the
+// oldest segment is dropped as a whole.
+class AudioCache final {
+public:
+    struct Config {
+        std::string root{};
+        std::string model_version{};
+        uint64_t max_bytes{256ULL << 20};
+        uint64_t segment_bytes{32ULL << 20};
+    };
+
+    static inline constexpr uint64_t INDEX_MAGIC = 0x3130434144474F44ULL; // "DOGEAC01"
+    static inline constexpr auto INDEX_FILE_NAME = "index.bin";
+    static inline constexpr auto SEGMENT_FILE_PREFIX = "segment_";
+    static inline constexpr auto SEGMENT_FILE_SUFFIX = ".bin";
+
+    explicit AudioCache(const Config &config);
+    ~AudioCache();
+
+    // lexicon is LanguageHelper::lexicon_hash, so audio of a sentence whose
+    // pronunciation may have changed is synthesized again, also after a restart,
+    // while a redeploy of the same sources keeps the cache.
+    uint64_t make_key(const std::string &text, int64_t speaker, float speed, uint64_t lexicon) const;
+
+    // On hit the message references the mapped samples instead of copying them.
+    bool lookup(uint64_t key, message::AudioMessage &msg) const;
+
+    bool insert(uint64_t key, const float *data, size_t size, uint32_t sample_rate);
+
+private:
+    struct Segment;
+
+    struct IndexRecord {
+        uint64_t key;
+        uint32_t segment_id;
+        uint32_t sample_rate;
+        uint64_t offset;
+        uint64_t sample_count;
+    };
+
+    std::string segment_path(uint32_t id) const;
+    std::shared_ptr<Segment> open_segment(uint32_t id, bool create);
+    void load();
+    void evict();
+    void rewrite_index();
+
+    AudioCache(const AudioCache &) = delete;
+    AudioCache &operator=(const AudioCache &) = delete;
+
+private:
+    Config config_{};
+
+    mutable std::mutex mutex_{};
+    std::ofstream index_{};
+    std::map<uint32_t, std::shared_ptr<Segment>> segments_{};
+    std::unordered_map<uint64_t, IndexRecord> records_{};
+};
+
+} // namespace model
+
+} // namespace lisa
+
+#endif
@@ -0,0 +1,73 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_MODEL_MELO_BATCHER_H_
+#define INCLUDE_MODEL_MELO_BATCHER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "model/executor.h"
+
+namespace lisa {
+
+namespace model {
+
+// Collects preprocessed sentences from concurrent callers and runs them through
+// the executor as one padded batch. Only sentences with the same speed share a
+// batch, since speed is a scalar model input. Batching needs a model that
+// reports the length of every item, without it sentences run one at a time.
+class MeloBatcher final {
+public:
+    struct Config {
+        uint32_t max_batch_size{8};
+        uint32_t max_delay_ms{10};
+    };
+
+    static inline constexpr auto SHARED_INPUT_NAME = "speed";
+
+    explicit MeloBatcher(std::shared_ptr<Executor> executor, const Config &config);
+    ~MeloBatcher();
+
+    // Resolves to the synthesized audio of this sentence, empty on failure.
+    std::future<std::vector<float>> submit(InputData input);
+
+private:
+    struct Request {
+        InputData input{};
+        float speed{};
+        std::chrono::steady_clock::time_point deadline{};
+        std::promise<std::vector<float>> promise{};
+    };
+
+    void run();
+    void process(std::vector<Request> &batch);
+
+    static InputData collate(const std::vector<Request> &batch);
+    static std::vector<float> slice(const OutputData &output, size_t index, size_t count);
+
+    MeloBatcher(const MeloBatcher &) = delete;
+    MeloBatcher &operator=(const MeloBatcher &) = delete;
+
+private:
+    std::shared_ptr<Executor> executor_{};
+    Config config_{};
+
+    bool batching_{true}; // only touched by thread_
+    bool running_{true};
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+    std::deque<Request> pending_{};
+    std::thread thread_{};
+};
+
+} // namespace model
+
+} // namespace lisa
+
+#endif
@@ -0,0 +1,73 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_MODEL_MELO_EXECUTOR_H_
+#define INCLUDE_MODEL_MELO_EXECUTOR_H_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "model/executor.h"
+
+namespace ov {
+class Core;
+class CompiledModel;
+class InferRequest;
+} // namespace ov
+
+namespace lisa {
+
+namespace model {
+
+class MeloExecutor final : public Executor {
+public:
+    static inline constexpr auto OUTPUT_NAME = "output";
+    // Samples of each item before padding, int64, for exports that report it.
+    static inline constexpr auto LENGTH_OUTPUT_NAME = "output_lengths";
+    static inline constexpr auto SAMPLE_RATE = 44100;
+
+    // Zero, negative or empty values leave the setting to the device default.
+    struct Config {
+        std::string device{"AUTO"};
+        std::string performance_hint{};  // "LATENCY", "THROUGHPUT" or "CUMULATIVE_THROUGHPUT"
+        int32_t num_streams{0};          // -1 lets the device pick the stream count
+        int32_t inference_threads{0};
+        int32_t cpu_pinning{-1};         // 0 disables, 1 enables
+        std::string cache_dir{};         // compiled blobs are reused across restarts
+        uint32_t request_count{0};       // 0 uses the optimal number reported by the device
+    };
+
+    explicit MeloExecutor(const std::string &model_path, const Config &config);
+    ~MeloExecutor() override;
+
+    bool infer(const InputData &input, OutputData &output) override;
+
+    uint32_t request_count() const { return static_cast<uint32_t>(requests_.size()); }
+
+private:
+    void report_properties() const;
+
+    ov::InferRequest *acquire_request();
+    void release_request(ov::InferRequest *request);
+
+    MeloExecutor(const MeloExecutor &) = delete;
+    MeloExecutor &operator=(const MeloExecutor &) = delete;
+
+private:
+    std::unique_ptr<ov::Core> core_{};
+    std::unique_ptr<ov::CompiledModel> compiled_model_{};
+
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+    std::vector<std::unique_ptr<ov::InferRequest>> requests_{};
+    std::deque<ov::InferRequest *> idle_requests_{};
+};
+
+} // namespace model
+
+} // namespace lisa
+
+#endif
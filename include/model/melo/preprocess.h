@@ -3,12 +3,12 @@
 #ifndef INCLUDE_MODEL_MELO_PREPROCESS_H_
 #define INCLUDE_MODEL_MELO_PREPROCESS_H_
 
+#include <memory_resource>
 #include <string>
-#include <type_traits>
-#include <unordered_map>
 #include <vector>
 
 #include "model/data.h"
+#include "utils/lru_cache.h"
 
 namespace lisa {
 
@@ -24,24 +24,50 @@ public:
 
     static inline constexpr auto SPEAKERS_ID = 1;
 
+    static inline constexpr auto PHONEME_CACHE_CAPACITY = 4096;
+    static inline constexpr auto PHONEME_CACHE_SHARDS = 16;
+
+    struct PhonemeSequence {
+        std::vector<int64_t> phones{};
+        std::vector<int64_t> tones{};
+        std::vector<int64_t> langs{};
+    };
+
+    // Keyed by the lexicon hash and the normalized sentence, speed just feeds
+    // the scalar speed input. Entries of a lexicon reloaded since are never hit
+    // again and age out.
+    using PhonemeCache = lisa::utils::LruCache<std::string, PhonemeSequence>;
+    // Keyed by the lexicon hash, the raw input and split length, so repeated
+    // prompts skip normalization too and a reload starts both caches over.
+    using SplitCache = lisa::utils::LruCache<std::string, std::vector<std::string>>;
+
     std::vector<std::string> split(const std::string &sentence, size_t max_len = 12) const;
 
-    lisa::model::InputData preprocess(const std::string &text, float speed = 1.0) const;
+    // The temporaries of phonemizing come from arena, to be released by the caller
+    // once the request is done, the inputs returned own their buffers. Without
+    // an arena the call uses one of its own.
+    lisa::model::InputData preprocess(const std::string &text, float speed = 1.0,
+                                      std::pmr::memory_resource *arena = nullptr) const;
+
+    static PhonemeCache::Stats phoneme_cache_stats();
+    static SplitCache::Stats split_cache_stats();
+
+    // Empties both caches, e.g. to measure the uncached path.
+    static void clear_caches();
 
 private:
-    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
-    std::vector<T> add_blank(const std::vector<T> &data) const {
-        std::vector<T> result = {0};
-        for (const auto &d : data) {
-            result.push_back(d);
-            result.push_back(0);
-        }
-        return result;
-    }
-
-    static const std::unordered_map<std::string, uint32_t> symbol_id_mapper_;
-
-    uint32_t get_symbol_id(const std::string &symbol) const;
+    static PhonemeCache &phoneme_cache();
+    static SplitCache &split_cache();
+
+    std::vector<std::string> split_uncached(const std::string &sentence, size_t min_len) const;
+
+    // With a blank before, between and after the phonemes.
+    PhonemeSequence phonemize(const std::string &text, std::pmr::memory_resource *arena) const;
+
+    // Melo symbol id indexed by SymbolTable id, -1 where the symbol is not a melo one.
+    static const std::vector<int32_t> &symbol_id_table();
+
+    uint32_t get_symbol_id(uint32_t symbol) const;
 };
 
 } // namespace model
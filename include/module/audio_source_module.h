@@ -0,0 +1,307 @@
+// cute-giggle@outlook.com
+
+#ifndef MODULE_AUDIO_SOURCE_MODULE_H_
+#define MODULE_AUDIO_SOURCE_MODULE_H_
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "message/audio_message.h"
+#include "message/message_center.h"
+#include "message/message_pool.h"
+#include "module/module.h"
+#include "spdlog/spdlog.h"
+#include "utils/io.h"
+#include "utils/time.h"
+
+namespace lisa {
+
+namespace module {
+
+// Publishes audio read from a wav file, a pipe of raw PCM or a local socket to
+// the output queue, one pooled AudioMessage per frame of fixed duration. The
+// time_stamp_ of a frame is when it is due on the steady clock in microseconds,
+// sequence_ counts frames from the start. Paced like a microphone, a multiple of
+// it, or as fast as the consumer takes them, so recognition can be driven
+// continuously and load tested without audio hardware.
+class AudioSourceModule final : public Module {
+public:
+    static constexpr auto RETRY_MS = 100U; // between attempts to open, and waits on a silent source
+    static constexpr auto POOL_RETRY_MS = 10U;
+
+    enum class Source : uint32_t {
+        WAV_FILE = 0,
+        PCM_PIPE = 1,    // raw interleaved samples from a fifo, "-" for stdin
+        UNIX_SOCKET = 2, // raw interleaved samples from a stream socket the module connects to
+    };
+
+    enum class Pacing : uint32_t {
+        REAL_TIME = 0,
+        SCALED = 1,       // speed times real time
+        UNTHROTTLED = 2,  // as fast as frames are read and the pool allows
+    };
+
+    struct Config {
+        Source source{Source::WAV_FILE};
+        std::string path{};
+        // Raw PCM carries no header, a wav file brings its own.
+        uint32_t sample_rate{16000};
+        uint32_t channels{1};
+        bool float_samples{false}; // raw samples are 32 bit float rather than 16 bit, little endian
+        uint32_t frame_ms{20};
+        Pacing pacing{Pacing::REAL_TIME};
+        double speed{1.0};
+        bool repeat{false}; // at the end, rewind the file or reopen the pipe or socket
+    };
+
+    explicit AudioSourceModule(const std::string &module_name, const std::string &output_queue_name,
+                               const Config &config, uint32_t audio_msg_count = 16)
+        : Module(module_name), output_queue_name_(output_queue_name), config_(config), audio_pool_(audio_msg_count) {
+        assert(config_.frame_ms > 0 && config_.channels > 0 && config_.sample_rate > 0);
+        assert(config_.pacing != Pacing::SCALED || config_.speed > 0.0);
+    }
+
+    ~AudioSourceModule() override {
+        stop();
+        join();
+        close_source();
+    }
+
+    // The source ended and is not repeated, nothing more is published.
+    bool finished() const { return finished_; }
+
+    // Frames published so far.
+    uint64_t frames() const { return sequence_; }
+
+private:
+    void initialize() override {
+        assert(!running());
+        output_queue_ = message::MessageCenter::instance().get_queue(output_queue_name_);
+        assert(output_queue_ != nullptr);
+    }
+
+    void finalize() override { assert(!running()); }
+
+    void loop() override {
+        if (finished_ || (!is_open() && !open_source())) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_MS));
+            return;
+        }
+        auto audio_msg = acquire_audio_message();
+        if (!audio_msg) {
+            return;
+        }
+        if (!read_frame(*audio_msg)) {
+            return;
+        }
+        const auto due = due_us(audio_msg->size() / audio_msg->channels_);
+        if (config_.pacing != Pacing::UNTHROTTLED) {
+            // Sleeps in short steps to notice a stop.
+            while (running() && utils::current_ts_us() < due) {
+                const auto wait = std::min<uint64_t>(due - utils::current_ts_us(), RETRY_MS * 1000);
+                std::this_thread::sleep_for(std::chrono::microseconds(wait));
+            }
+        }
+        audio_msg->time_stamp_ = config_.pacing == Pacing::UNTHROTTLED ? utils::current_ts_us() : due;
+        audio_msg->sequence_ = sequence_++;
+        output_queue_->push(audio_msg);
+    }
+
+    bool is_open() const { return reader_ != nullptr || fd_ >= 0; }
+
+    bool open_source() {
+        switch (config_.source) {
+        case Source::WAV_FILE:
+            reader_ = std::make_unique<utils::WavReader>(config_.path);
+            if (!reader_->is_open()) {
+                reader_.reset();
+                finished_ = true;
+                return false;
+            }
+            sample_rate_ = reader_->sample_rate();
+            channels_ = reader_->channels();
+            break;
+        case Source::PCM_PIPE:
+            // Nonblocking, a fifo without a writer would block the open.
+            fd_ = config_.path == "-" ? dup(STDIN_FILENO) : open(config_.path.c_str(), O_RDONLY | O_NONBLOCK);
+            break;
+        case Source::UNIX_SOCKET:
+            fd_ = connect_socket(config_.path);
+            break;
+        }
+        if (config_.source != Source::WAV_FILE) {
+            if (fd_ < 0) {
+                return false;
+            }
+            sample_rate_ = config_.sample_rate;
+            channels_ = config_.channels;
+        }
+        frame_size_ = std::max<size_t>(size_t(sample_rate_) * config_.frame_ms / 1000, 1) * channels_;
+        raw_size_ = 0;
+        received_ = false;
+        // Pacing starts over with each opening, so a reopened source does not burst to catch up.
+        start_us_ = utils::current_ts_us();
+        start_frames_ = 0;
+        spdlog::info("Audio source [{}] opened [{}], sample rate: {}, channels: {}", name(), config_.path, sample_rate_,
+                     channels_);
+        return true;
+    }
+
+    static int connect_socket(const std::string &path) {
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path)) {
+            spdlog::error("Socket path too long: {}", path);
+            return -1;
+        }
+        address.sun_family = AF_UNIX;
+        std::copy(path.begin(), path.end(), address.sun_path);
+        const auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void close_source() {
+        reader_.reset();
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // Opened again by the next loop when repeating.
+    void end_source() {
+        spdlog::info("Audio source [{}] reached the end of [{}], frames: {}", name(), config_.path, sequence_.load());
+        close_source();
+        finished_ = !config_.repeat;
+    }
+
+    // A whole frame, or the rest before the end, into the message. False if none
+    // is ready yet.
+    bool read_frame(message::AudioMessage &audio_msg) {
+        audio_msg.channels_ = channels_;
+        audio_msg.sample_rate_ = sample_rate_;
+        if (reader_ != nullptr) {
+            if (!reader_->read(audio_msg.data_, frame_size_ / channels_)) {
+                end_source();
+                return false;
+            }
+            return true;
+        }
+
+        const auto sample_bytes = config_.float_samples ? sizeof(float) : sizeof(int16_t);
+        raw_.resize(frame_size_ * sample_bytes);
+        auto ended = false;
+        while (running() && raw_size_ < raw_.size()) {
+            pollfd target{fd_, POLLIN, 0};
+            const auto ready = poll(&target, 1, RETRY_MS);
+            if (ready == 0 || (ready < 0 && errno == EINTR)) {
+                continue;
+            }
+            const auto count = ready < 0 ? -1 : read(fd_, raw_.data() + raw_size_, raw_.size() - raw_size_);
+            if (count < 0 && (errno == EAGAIN || errno == EINTR)) {
+                continue;
+            }
+            if (count == 0 && config_.source == Source::PCM_PIPE && !received_) {
+                // The fifo has had no writer yet.
+                std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_MS));
+                continue;
+            }
+            if (count <= 0) {
+                if (count < 0) {
+                    spdlog::error("Audio source [{}] read failed: {}", name(), strerror(errno));
+                }
+                ended = true;
+                break;
+            }
+            raw_size_ += count;
+            received_ = true;
+        }
+        // Whole frames of every channel only, a torn sample at the end is dropped.
+        const auto samples = raw_size_ / (sample_bytes * channels_) * channels_;
+        if (!ended && raw_size_ < raw_.size()) {
+            return false;
+        }
+        audio_msg.data_.resize(samples);
+        if (config_.float_samples) {
+            std::memcpy(audio_msg.data_.data(), raw_.data(), samples * sizeof(float));
+        } else {
+            const auto *pcm = reinterpret_cast<const int16_t *>(raw_.data());
+            std::transform(pcm, pcm + samples, audio_msg.data_.begin(),
+                           [](int16_t sample) { return sample * (1.0f / 32768.0f); });
+        }
+        raw_size_ = 0;
+        if (ended) {
+            end_source();
+        }
+        return samples > 0;
+    }
+
+    // When a frame of this many frames, following those published since opening,
+    // is due.
+    uint64_t due_us(size_t frames) {
+        start_frames_ += frames;
+        if (config_.pacing == Pacing::UNTHROTTLED) {
+            return start_us_;
+        }
+        const auto speed = config_.pacing == Pacing::SCALED ? config_.speed : 1.0;
+        // The frame is due once it would have been heard to its end.
+        return start_us_ + static_cast<uint64_t>(start_frames_ * 1e6 / (sample_rate_ * speed));
+    }
+
+    // Blocks while every pooled message is still held downstream, so a slow
+    // consumer slows the source down rather than frames piling up.
+    std::shared_ptr<message::AudioMessage> acquire_audio_message() {
+        while (running()) {
+            auto audio_msg = audio_pool_.get();
+            if (audio_msg) {
+                return audio_msg;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(POOL_RETRY_MS));
+        }
+        return nullptr;
+    }
+
+private:
+    std::string output_queue_name_{};
+    Config config_{};
+    message::MessagePool<message::AudioMessage> audio_pool_;
+    std::shared_ptr<message::MessageQueue> output_queue_{};
+
+    std::unique_ptr<utils::WavReader> reader_{};
+    int fd_{-1};
+    uint32_t sample_rate_{};
+    uint32_t channels_{};
+    size_t frame_size_{}; // samples of every channel
+    std::vector<char> raw_{};
+    size_t raw_size_{};   // bytes of raw_ read towards the current frame
+    bool received_{false}; // any bytes since opening
+
+    uint64_t start_us_{};
+    uint64_t start_frames_{};
+    std::atomic<uint64_t> sequence_{};
+    std::atomic<bool> finished_{false};
+};
+
+} // namespace module
+
+} // namespace lisa
+
+#endif
@@ -0,0 +1,223 @@
+// cute-giggle@outlook.com
+
+#ifndef MODULE_MELO_MODULE_H_
+#define MODULE_MELO_MODULE_H_
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "language/language.h"
+#include "language/splitter.h"
+#include "message/audio_message.h"
+#include "message/message_center.h"
+#include "message/message_pool.h"
+#include "message/text_message.h"
+#include "model/executor.h"
+#include "model/melo/audio_cache.h"
+#include "model/melo/batcher.h"
+#include "model/melo/executor.h"
+#include "model/melo/preprocess.h"
+#include "module/module.h"
+#include "spdlog/spdlog.h"
+#include "utils/arena.h"
+#include "utils/audio.h"
+
+namespace lisa {
+
+namespace module {
+
+// Consumes TextMessage from its own queue and publishes one AudioMessage per
+// synthesized chunk to the output queue. Chunks are cut from the text as they
+// are synthesized, so a long document starts playing after its first one. Text
+// streamed over partial messages is spoken sentence by sentence as each one
+// completes.
+// Chunks found in the optional audio cache skip inference and reference the
+// cached samples directly. With the optional post processor, owned by the
+// module as it carries the state of its stream, every chunk is leveled and
+// crossfaded into the next in its pooled buffer, the cache keeps the samples as
+// synthesized.
+// With a batcher, chunks are synthesized through it rather than straight on the
+// executor. Modules given one from make_batcher share its batches.
+class MeloModule final : public Module {
+public:
+    static constexpr auto WAIT_TIMEOUT_MS = 100U;
+    static constexpr auto POOL_RETRY_MS = 10U;
+    static constexpr auto SPLIT_TARGET_COST = 32U; // estimated phones per chunk
+    static constexpr auto SPLIT_MAX_COST = 96U;
+    static constexpr auto BATCH_MAX_SIZE = 8U;
+    static constexpr auto BATCH_MAX_DELAY_MS = 10U;
+
+    explicit MeloModule(const std::string &module_name, const std::string &output_queue_name,
+                        std::shared_ptr<model::Executor> executor, uint32_t audio_msg_count = 16,
+                        std::shared_ptr<model::AudioCache> audio_cache = nullptr,
+                        std::unique_ptr<utils::AudioPostProcessor> post_processor = nullptr,
+                        std::shared_ptr<model::MeloBatcher> batcher = nullptr)
+        : Module(module_name), output_queue_name_(output_queue_name), executor_(std::move(executor)),
+          batcher_(std::move(batcher)), audio_cache_(std::move(audio_cache)), post_processor_(std::move(post_processor)),
+          splitter_(split_config(false)), audio_pool_(audio_msg_count) {}
+
+    ~MeloModule() override {
+        stop();
+        join();
+    }
+
+    // A batcher over executor to be shared by the modules synthesizing on it.
+    static std::shared_ptr<model::MeloBatcher> make_batcher(std::shared_ptr<model::Executor> executor) {
+        model::MeloBatcher::Config config;
+        config.max_batch_size = BATCH_MAX_SIZE;
+        config.max_delay_ms = BATCH_MAX_DELAY_MS;
+        return std::make_shared<model::MeloBatcher>(std::move(executor), config);
+    }
+
+private:
+    void initialize() override {
+        assert(!running());
+        assert(executor_ != nullptr || batcher_ != nullptr);
+        queue_ = message::MessageCenter::instance().get_queue(name());
+        assert(queue_ != nullptr);
+        output_queue_ = message::MessageCenter::instance().get_queue(output_queue_name_);
+        assert(output_queue_ != nullptr);
+    }
+
+    void finalize() override { assert(!running()); }
+
+    void loop() override {
+        auto msg = queue_->wait_for(WAIT_TIMEOUT_MS);
+        if (!running() || !msg) {
+            return;
+        }
+        auto text_msg = std::dynamic_pointer_cast<message::TextMessage>(msg);
+        if (!text_msg) {
+            spdlog::warn("Melo module [{}] received non text message", name());
+            return;
+        }
+
+        if (!streaming_) {
+            splitter_ = language::StreamSplitter(split_config(text_msg->partial_));
+        }
+        streaming_ = text_msg->partial_;
+        splitter_.push(text_msg->text_);
+        if (!text_msg->partial_) {
+            splitter_.finish();
+        }
+        // One chunk ahead, the post processor has to know which one ends the text.
+        std::string sentence;
+        std::string following;
+        auto more = splitter_.next(sentence);
+        while (more) {
+            more = splitter_.next(following);
+            const auto last = !more && !text_msg->partial_;
+            auto audio_msg = acquire_audio_message();
+            if (!audio_msg) {
+                return;
+            }
+            const auto key = audio_cache_ ? audio_cache_->make_key(sentence, model::MeloPreprocessor::SPEAKERS_ID,
+                                                                   text_msg->speed_, lexicon_hash())
+                                          : 0;
+            if (!audio_cache_ || !audio_cache_->lookup(key, *audio_msg)) {
+                auto input = preprocessor_.preprocess(sentence, text_msg->speed_, arena_.resource());
+                arena_.release();
+                if (!synthesize(std::move(input), audio_msg->data_)) {
+                    spdlog::error("Melo module [{}] infer failed, sentence: [{}]", name(), sentence);
+                    sentence.swap(following);
+                    continue;
+                }
+                audio_msg->channels_ = 1;
+                audio_msg->sample_rate_ = model::MeloExecutor::SAMPLE_RATE;
+                if (audio_cache_) {
+                    audio_cache_->insert(key, audio_msg->data_.data(), audio_msg->data_.size(), audio_msg->sample_rate_);
+                }
+            }
+            if (post_processor_) {
+                if (audio_msg->view_) {
+                    audio_msg->data_.assign(audio_msg->samples(), audio_msg->samples() + audio_msg->size());
+                    audio_msg->view_.reset();
+                    audio_msg->view_size_ = 0;
+                }
+                post_processor_->process(audio_msg->data_, last);
+            }
+            publish(audio_msg, *text_msg);
+            sentence.swap(following);
+        }
+        // The text ended without a chunk of its own, what was held back for it goes out alone.
+        if (post_processor_ && !text_msg->partial_ && post_processor_->pending() > 0) {
+            auto audio_msg = acquire_audio_message();
+            if (!audio_msg) {
+                return;
+            }
+            audio_msg->channels_ = 1;
+            audio_msg->sample_rate_ = model::MeloExecutor::SAMPLE_RATE;
+            post_processor_->flush(audio_msg->data_);
+            publish(audio_msg, *text_msg);
+        }
+    }
+
+    bool synthesize(model::InputData input, std::vector<float> &audio) {
+        if (batcher_) {
+            audio = batcher_->submit(std::move(input)).get();
+            return !audio.empty();
+        }
+        model::OutputData output;
+        if (!executor_->infer(input, output) || output.count(model::MeloExecutor::OUTPUT_NAME) == 0) {
+            return false;
+        }
+        const auto &buffer = output.at(model::MeloExecutor::OUTPUT_NAME).buffer;
+        const auto data = reinterpret_cast<const float *>(buffer.data());
+        audio.assign(data, data + buffer.size() / sizeof(float));
+        return true;
+    }
+
+    static uint64_t lexicon_hash() { return language::LanguageHelper::instance().lexicon_hash(); }
+
+    void publish(const std::shared_ptr<message::AudioMessage> &audio_msg, const message::TextMessage &text_msg) {
+        audio_msg->time_stamp_ = text_msg.time_stamp_;
+        audio_msg->sequence_ = sequence_++;
+        output_queue_->push(audio_msg);
+    }
+
+    // Streamed text is released at every sentence end rather than held back to
+    // fill the target.
+    static language::StreamSplitter::Config split_config(bool streaming) {
+        language::StreamSplitter::Config config;
+        config.target_cost = SPLIT_TARGET_COST;
+        config.max_cost = SPLIT_MAX_COST;
+        config.eager = streaming;
+        return config;
+    }
+
+    // Blocks while every pooled message is still held downstream, which keeps a
+    // slow consumer from letting synthesized audio pile up without bound.
+    std::shared_ptr<message::AudioMessage> acquire_audio_message() {
+        while (running()) {
+            auto audio_msg = audio_pool_.get();
+            if (audio_msg) {
+                return audio_msg;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(POOL_RETRY_MS));
+        }
+        return nullptr;
+    }
+
+private:
+    std::string output_queue_name_{};
+    std::shared_ptr<model::Executor> executor_{};
+    std::shared_ptr<model::MeloBatcher> batcher_{};
+    std::shared_ptr<model::AudioCache> audio_cache_{};
+    std::unique_ptr<utils::AudioPostProcessor> post_processor_{}; // state of this module's stream
+    model::MeloPreprocessor preprocessor_{};
+    utils::Arena arena_{}; // temporaries of preprocessing one chunk
+    language::StreamSplitter splitter_;
+    bool streaming_{false}; // a partial message was the last one
+    message::MessagePool<message::AudioMessage> audio_pool_;
+    uint64_t sequence_{};
+    std::shared_ptr<message::MessageQueue> queue_{};
+    std::shared_ptr<message::MessageQueue> output_queue_{};
+};
+
+} // namespace module
+
+} // namespace lisa
+
+#endif
@@ -19,9 +19,7 @@ public:
 
     virtual ~Module() {
         stop();
-        if (thread_.joinable()) {
-            thread_.join();
-        }
+        join();
     }
 
     void start() {
@@ -46,6 +44,14 @@ public:
     bool running() const { return running_; }
 
 protected:
+    // Subclasses whose loop touches their own members must stop and join in
+    // their destructor, before those members are destroyed.
+    void join() {
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
     virtual void initialize() = 0;
     virtual void finalize() = 0;
     virtual void loop() = 0;
@@ -53,7 +53,7 @@ private:
         assert(audio_msg);
 
         static constexpr auto processor_count = 1;
-        if (whisper_full_parallel(ctx_, full_params_, audio_msg->data_.data(), audio_msg->data_.size(), processor_count) != 0) {
+        if (whisper_full_parallel(ctx_, full_params_, audio_msg->samples(), audio_msg->size(), processor_count) != 0) {
             fprintf(stderr, "failed to process audio\n");
             return;
         }
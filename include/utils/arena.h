@@ -0,0 +1,49 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_UTILS_ARENA_H_
+#define INCLUDE_UTILS_ARENA_H_
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+
+namespace lisa {
+
+namespace utils {
+
+// Bump allocator for the temporaries of one request, freed all at once by
+// release or when the arena goes away. The first block lives inside the arena,
+// so a typical sentence never reaches malloc, longer ones take further blocks
+// from the heap. One thread at a time, like the request it serves.
+class Arena final {
+public:
+    static constexpr size_t INLINE_SIZE = 16 * 1024;
+
+    Arena() = default;
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    std::pmr::memory_resource *resource() { return &resource_; }
+
+    // Everything allocated is gone, the inline block is used again.
+    void release() { resource_.release(); }
+
+private:
+    alignas(std::max_align_t) std::array<std::byte, INLINE_SIZE> buffer_;
+    std::pmr::monotonic_buffer_resource resource_{buffer_.data(), buffer_.size(), std::pmr::new_delete_resource()};
+};
+
+// A copy of text that lives as long as what else was allocated from resource.
+inline std::string_view copy(std::string_view text, std::pmr::memory_resource *resource) {
+    auto *data = static_cast<char *>(resource->allocate(text.size(), alignof(char)));
+    text.copy(data, text.size());
+    return {data, text.size()};
+}
+
+} // namespace utils
+
+} // namespace lisa
+
+#endif
@@ -0,0 +1,95 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_UTILS_AUDIO_H_
+#define INCLUDE_UTILS_AUDIO_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lisa {
+
+namespace utils {
+
+// Mono float sample kernels, 4 samples at a time where SSE2 is available.
+
+struct AudioLevel {
+    float peak{}; // largest absolute sample
+    float rms{};
+};
+
+AudioLevel audio_level(const float *data, size_t size);
+
+// Multiplies by a gain moving linearly from begin to end over the samples.
+void apply_gain(float *data, size_t size, float begin, float end);
+
+// Mixes the end of one signal into the start of the next in place, tail fading
+// out while head fades in.
+void crossfade(const float *tail, float *head, size_t size);
+
+// Samples before the first one louder than threshold, size if there is none.
+size_t leading_silence(const float *data, size_t size, float threshold);
+
+// Samples after the last one louder than threshold, size if there is none.
+size_t trailing_silence(const float *data, size_t size, float threshold);
+
+// Converts to 16 bit with triangular dither of one LSB, seed carries the noise
+// state from one call to the next.
+void float_to_int16(const float *data, size_t size, int16_t *result, uint32_t &seed);
+
+// Cleans up the chunks synthesized for one utterance, in place in their own
+// buffers, so they play back to back:
+//  - the level is brought to a target RMS, kept under a peak limit, the gain
+//    gliding from the previous chunk's over the first few milliseconds;
+//  - each chunk holds back its last samples to crossfade them into the head of
+//    the next one, so the seams do not click;
+//  - silence before the first chunk and after the last one is trimmed down to
+//    a margin.
+// A chunk shrinks by the samples held back, they come out with the next chunk,
+// or the tail on the last one.
+// Carries the state of one stream and is not thread safe, every stream needs
+// one of its own.
+class AudioPostProcessor final {
+public:
+    struct Config {
+        uint32_t sample_rate{44100};
+        float target_rms{0.1f};     // 0 keeps the level as synthesized
+        float peak_limit{0.95f};
+        float max_gain{8.0f};       // keeps near silent chunks from being blown up
+        float gain_glide_ms{20.0f};
+        float crossfade_ms{8.0f};
+        bool trim{true};
+        float trim_threshold{0.01f};
+        float trim_margin_ms{40.0f}; // kept around the voice
+    };
+
+    explicit AudioPostProcessor(const Config &config);
+
+    // last ends the utterance: nothing is held back and the next chunk starts a
+    // new one.
+    void process(std::vector<float> &chunk, bool last);
+
+    // Samples still held back, e.g. when an utterance ended with no chunk left to
+    // mark last. Appended to result, which is then the end of the utterance.
+    void flush(std::vector<float> &result);
+
+    size_t pending() const { return tail_.size(); }
+
+    void reset();
+
+private:
+    Config config_{};
+    size_t glide_size_{};
+    size_t crossfade_size_{};
+    size_t trim_margin_{};
+
+    bool started_{false};
+    float gain_{1.0f};
+    std::vector<float> tail_{};
+};
+
+} // namespace utils
+
+} // namespace lisa
+
+#endif
@@ -3,15 +3,28 @@
 #ifndef INCLUDE_UTILS_IO_H_
 #define INCLUDE_UTILS_IO_H_
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
-#include <iterator>
-#include <sstream>
+#include <functional>
+#include <limits>
+#include <numeric>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "model/data.h"
 #include "sndfile.h"
 #include "spdlog/spdlog.h"
 
@@ -19,6 +32,49 @@ namespace lisa {
 
 namespace utils {
 
+// A whole file mapped read only, empty when it cannot be.
+class MappedFile final {
+public:
+    explicit MappedFile(const std::string &path) {
+        const auto fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st {};
+        if (fstat(fd, &st) == 0) {
+            const auto mapping =
+                st.st_size > 0 ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            if (mapping != MAP_FAILED) {
+                data_ = static_cast<const char *>(mapping);
+                size_ = st.st_size;
+            }
+            opened_ = mapping != MAP_FAILED || st.st_size == 0;
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // An empty file is open, with nothing in it.
+    bool is_open() const { return opened_; }
+
+    std::string_view view() const { return {data_, size_}; }
+
+private:
+    const char *data_{};
+    size_t size_{};
+    bool opened_{false};
+};
+
+// Numbers separated by any of seps or white space. Like reading the line with
+// operator>>, a token that is not a number drops the rest of its line.
 template <typename T, typename std::enable_if_t<std::is_arithmetic_v<T>, void> * = nullptr>
 std::vector<T> read_txt(const std::string &path, const std::string &seps = " ") {
     if (!std::filesystem::exists(path)) {
@@ -26,66 +82,415 @@ std::vector<T> read_txt(const std::string &path, const std::string &seps = " ")
         return {};
     }
 
-    std::ifstream ifs(path, std::ios_base::in);
-    if (!ifs.is_open()) {
+    MappedFile file(path);
+    if (!file.is_open()) {
         spdlog::error("Open file failed! target path: {}", path);
         return {};
     }
 
+    std::array<bool, 256> is_sep{};
+    for (const auto sep : seps + " \t\r\n\v\f") {
+        is_sep[static_cast<uint8_t>(sep)] = true;
+    }
     std::vector<T> result;
-    std::string line_buffer;
-    while (std::getline(ifs, line_buffer)) {
-        for (auto sep : seps) {
-            std::replace(line_buffer.begin(), line_buffer.end(), sep, ' ');
+    const auto text = file.view();
+    const auto *pos = text.data();
+    const auto *end = text.data() + text.size();
+    while (pos < end) {
+        if (is_sep[static_cast<uint8_t>(*pos)]) {
+            ++pos;
+            continue;
+        }
+        // from_chars takes no plus sign, operator>> does.
+        const auto *number = *pos == '+' && pos + 1 < end && pos[1] != '-' ? pos + 1 : pos;
+        T value{};
+        const auto [next, error] = std::from_chars(number, end, value);
+        if (error != std::errc()) {
+            const auto *line_end = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+            pos = line_end != nullptr ? line_end + 1 : end;
+            continue;
         }
-        std::stringstream ss(line_buffer);
-        std::copy(std::istream_iterator<T>{ss}, std::istream_iterator<T>{}, std::back_inserter(result));
+        result.push_back(value);
+        pos = next;
     }
 
     return result;
 }
 
+// Each value followed by sep, floating point ones in their shortest form that
+// reads back to the same value.
 template <typename T, typename std::enable_if_t<std::is_arithmetic_v<T>, void> * = nullptr>
 bool save_txt(const std::string &path, const T *buffer, size_t size, const char sep = ' ') {
-    std::ofstream ofs(path, std::ios_base::out);
+    std::ofstream ofs(path, std::ios_base::out | std::ios_base::binary);
     if (!ofs.is_open()) {
         spdlog::error("Open file failed! target path: {}", path);
         return false;
     }
 
-    for (auto i = 0U; i < size; ++i) {
-        ofs << buffer[i] << sep;
+    static constexpr size_t FLUSH_SIZE = 1 << 16;
+    std::string text;
+    text.reserve(FLUSH_SIZE + 64);
+    char number[64];
+    for (size_t i = 0; i < size; ++i) {
+        const auto result = std::to_chars(number, number + sizeof(number), buffer[i]);
+        text.append(number, result.ptr);
+        text.push_back(sep);
+        if (text.size() >= FLUSH_SIZE) {
+            ofs.write(text.data(), text.size());
+            text.clear();
+        }
     }
+    ofs.write(text.data(), text.size());
 
     return ofs.good();
 }
 
-template <typename T> struct WavSaveMapping;
+// Element types of a .npy array, by their numpy type descriptor. Arrays are
+// stored as little endian, the byte order of every supported host.
+template <typename T> struct NpyTypeMapping;
 
-template <> struct WavSaveMapping<float> {
-    static constexpr auto format = SF_FORMAT_FLOAT;
-    static constexpr auto function = sf_write_float;
+template <> struct NpyTypeMapping<float> {
+    static constexpr auto descr = "<f4";
 };
 
-template <typename T, typename std::enable_if_t<std::is_arithmetic_v<T>, void> * = nullptr>
-bool save_wav(const std::string &path, const T *data, size_t size, uint32_t sample_rate, uint32_t channels) {
-    SF_INFO sfinfo = {static_cast<int64_t>(size / channels),
-                      static_cast<int>(sample_rate),
-                      static_cast<int>(channels),
-                      SF_FORMAT_WAV | WavSaveMapping<T>::format,
-                      0,
-                      0};
-
-    SNDFILE *outfile = sf_open(path.c_str(), SFM_WRITE, &sfinfo);
-    if (!outfile) {
+template <> struct NpyTypeMapping<double> {
+    static constexpr auto descr = "<f8";
+};
+
+template <> struct NpyTypeMapping<int64_t> {
+    static constexpr auto descr = "<i8";
+};
+
+template <> struct NpyTypeMapping<int32_t> {
+    static constexpr auto descr = "<i4";
+};
+
+template <> struct NpyTypeMapping<int16_t> {
+    static constexpr auto descr = "<i2";
+};
+
+template <> struct NpyTypeMapping<uint8_t> {
+    static constexpr auto descr = "|u1";
+};
+
+// A .npy file mapped read only, e.g. a test fixture used in place. Format
+// versions 1 to 3, C order only. Every header field is bounds checked, the file
+// may be truncated or not written by numpy.
+class NpyFile final {
+public:
+    static constexpr std::string_view MAGIC{"\x93NUMPY", 6};
+
+    explicit NpyFile(const std::string &path) : file_(path) {
+        const auto text = file_.view();
+        if (text.size() < MAGIC.size() + 2 || text.substr(0, MAGIC.size()) != MAGIC) {
+            spdlog::error("Not a npy file! target path: {}", path);
+            return;
+        }
+        const auto *bytes = reinterpret_cast<const uint8_t *>(text.data());
+        const auto major = bytes[6];
+        const size_t length_size = major == 1 ? 2 : 4;
+        if (major < 1 || major > 3 || text.size() < 8 + length_size) {
+            spdlog::error("Unsupported npy header! target path: {}", path);
+            return;
+        }
+        size_t header_size = 0;
+        for (size_t i = 0; i < length_size; ++i) {
+            header_size |= size_t(bytes[8 + i]) << (8 * i);
+        }
+        const auto offset = 8 + length_size + header_size;
+        if (offset > text.size()) {
+            spdlog::error("Npy header truncated! target path: {}", path);
+            return;
+        }
+        const auto header = text.substr(8 + length_size, header_size);
+        if (!parse_header(header)) {
+            spdlog::error("Unsupported npy header: {}, target path: {}", header, path);
+            return;
+        }
+        data_ = text.substr(offset);
+        const auto count = element_count();
+        if (data_.size() / element_size_ < count) {
+            spdlog::error("Npy data truncated! target path: {}", path);
+            data_ = {};
+            return;
+        }
+        data_ = data_.substr(0, count * element_size_);
+        valid_ = true;
+    }
+
+    bool is_valid() const { return valid_; }
+
+    const std::string &descr() const { return descr_; }
+    const model::DataShape &shape() const { return shape_; }
+
+    size_t element_count() const {
+        return std::accumulate(shape_.begin(), shape_.end(), size_t{1}, std::multiplies<>());
+    }
+
+    // The elements in place, nullptr unless they are of type T and aligned for
+    // it. numpy aligns them, other writers need not, bytes() serves those.
+    template <typename T> const T *data() const {
+        if (!valid_ || descr_ != NpyTypeMapping<T>::descr ||
+            reinterpret_cast<uintptr_t>(data_.data()) % alignof(T) != 0) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T *>(data_.data());
+    }
+
+    // The elements as stored, whatever their type and alignment.
+    std::string_view bytes() const { return data_; }
+
+private:
+    // The dictionary numpy writes, e.g. {'descr': '<f4', 'fortran_order': False, 'shape': (2, 3), }
+    bool parse_header(std::string_view header) {
+        const auto value_of = [&](std::string_view key) {
+            const auto pos = header.find(key);
+            if (pos == std::string_view::npos) {
+                return std::string_view{};
+            }
+            auto value = header.substr(pos + key.size());
+            value.remove_prefix(std::min(value.find_first_not_of(" :"), value.size()));
+            return value;
+        };
+        const auto descr = value_of("'descr'");
+        if (descr.size() < 2 || descr[0] != '\'') {
+            return false;
+        }
+        descr_ = std::string(descr.substr(1, descr.find('\'', 1) - 1));
+        if (value_of("'fortran_order'").substr(0, 5) != "False") {
+            return false;
+        }
+        auto shape = value_of("'shape'");
+        if (shape.empty() || shape[0] != '(') {
+            return false;
+        }
+        shape = shape.substr(1, shape.find(')') - 1);
+        shape_.clear();
+        size_t count = 1; // kept from overflowing, the data size is checked against it
+        while (!shape.empty()) {
+            shape.remove_prefix(std::min(shape.find_first_not_of(" ,"), shape.size()));
+            if (shape.empty()) {
+                break;
+            }
+            size_t dim = 0;
+            const auto [next, error] = std::from_chars(shape.data(), shape.data() + shape.size(), dim);
+            if (error != std::errc() || (dim != 0 && count > std::numeric_limits<size_t>::max() / dim)) {
+                return false;
+            }
+            count *= dim;
+            shape_.push_back(dim);
+            shape.remove_prefix(next - shape.data());
+        }
+        element_size_ = descr_.size() > 2 ? descr_[2] - '0' : 0;
+        return element_size_ > 0 && (descr_[0] == '<' || descr_[0] == '|');
+    }
+
+private:
+    MappedFile file_;
+    std::string descr_{};
+    model::DataShape shape_{};
+    size_t element_size_{};
+    std::string_view data_{};
+    bool valid_{false};
+};
+
+// Copies a .npy array of T elements into data, aligned or not in the file.
+template <typename T> bool load_npy(const std::string &path, model::Data &data) {
+    NpyFile file(path);
+    if (!file.is_valid() || file.descr() != NpyTypeMapping<T>::descr) {
+        spdlog::error("Load npy failed, expected {} elements, got [{}]! target path: {}", NpyTypeMapping<T>::descr,
+                      file.descr(), path);
+        return false;
+    }
+    const auto bytes = file.bytes();
+    data.buffer.assign(bytes.begin(), bytes.end());
+    data.shape = file.shape();
+    return true;
+}
+
+// Saves data, whose buffer holds T elements, as numpy does: format version 1.0
+// with the header padded so the array starts 64 byte aligned.
+template <typename T> bool save_npy(const std::string &path, const model::Data &data) {
+    const auto count = std::accumulate(data.shape.begin(), data.shape.end(), size_t{1}, std::multiplies<>());
+    if (count * sizeof(T) != data.buffer.size()) {
+        spdlog::error("Save npy failed, shape does not match the buffer! target path: {}", path);
+        return false;
+    }
+
+    std::string shape;
+    for (const auto dim : data.shape) {
+        shape += std::to_string(dim) + ", ";
+    }
+    // "(3,)" for a single dimension, "(2, 3)" for more.
+    if (data.shape.size() > 1) {
+        shape.resize(shape.size() - 2);
+    } else if (data.shape.size() == 1) {
+        shape.pop_back();
+    }
+    auto header = std::string("{'descr': '") + NpyTypeMapping<T>::descr + "', 'fortran_order': False, 'shape': (" +
+                  shape + "), }";
+    const auto total = (NpyFile::MAGIC.size() + 4 + header.size() + 1 + 63) / 64 * 64;
+    header.append(total - NpyFile::MAGIC.size() - 4 - header.size() - 1, ' ');
+    header.push_back('\n');
+
+    std::ofstream ofs(path, std::ios_base::out | std::ios_base::binary);
+    if (!ofs.is_open()) {
         spdlog::error("Open file failed! target path: {}", path);
         return false;
     }
+    const char version[4] = {1, 0, static_cast<char>(header.size() & 0xFF), static_cast<char>(header.size() >> 8)};
+    ofs.write(NpyFile::MAGIC.data(), NpyFile::MAGIC.size());
+    ofs.write(version, sizeof(version));
+    ofs.write(header.data(), header.size());
+    ofs.write(reinterpret_cast<const char *>(data.buffer.data()), data.buffer.size());
+
+    return ofs.good();
+}
+
+// Sample types a wav file is read into or written from, and the file format
+// that stores them as they are.
+template <typename T> struct WavSampleMapping;
+
+template <> struct WavSampleMapping<float> {
+    static constexpr auto format = SF_FORMAT_FLOAT;
+    static constexpr auto read = sf_readf_float;
+    static constexpr auto write = sf_writef_float;
+};
+
+template <> struct WavSampleMapping<int16_t> {
+    static constexpr auto format = SF_FORMAT_PCM_16;
+    static constexpr auto read = sf_readf_short;
+    static constexpr auto write = sf_writef_short;
+};
+
+// Reads a wav file a chunk at a time, e.g. straight into pooled AudioMessage
+// buffers, so a file of any length is held one chunk at a time. Samples come
+// converted to the type asked for, whatever the file stores.
+class WavReader final {
+public:
+    explicit WavReader(const std::string &path) {
+        file_ = sf_open(path.c_str(), SFM_READ, &info_);
+        if (file_ == nullptr) {
+            spdlog::error("Open file failed! target path: {}, error: {}", path, sf_strerror(nullptr));
+        }
+    }
+
+    ~WavReader() { close(); }
+
+    WavReader(const WavReader &) = delete;
+    WavReader &operator=(const WavReader &) = delete;
+
+    bool is_open() const { return file_ != nullptr; }
+
+    uint32_t sample_rate() const { return static_cast<uint32_t>(info_.samplerate); }
+    uint32_t channels() const { return static_cast<uint32_t>(info_.channels); }
+    uint64_t frames() const { return static_cast<uint64_t>(info_.frames); }
+
+    // Up to frames interleaved frames into data, the frames read, 0 at the end.
+    template <typename T> size_t read(T *data, size_t frames) {
+        if (file_ == nullptr) {
+            return 0;
+        }
+        const auto count = WavSampleMapping<T>::read(file_, data, static_cast<sf_count_t>(frames));
+        return count > 0 ? static_cast<size_t>(count) : 0;
+    }
+
+    // Replaces the buffer content with the next frames, its capacity is reused.
+    // False once the file is exhausted.
+    template <typename T> bool read(std::vector<T> &buffer, size_t frames) {
+        buffer.resize(frames * channels());
+        buffer.resize(read(buffer.data(), frames) * channels());
+        return !buffer.empty();
+    }
+
+    void close() {
+        if (file_ != nullptr) {
+            sf_close(file_);
+            file_ = nullptr;
+        }
+    }
+
+private:
+    SF_INFO info_{};
+    SNDFILE *file_{};
+};
+
+// Writes a wav file a chunk at a time. The header holds the sizes written so
+// far once closed, or after update_header for a reader following a file still
+// being written.
+class WavWriter final {
+public:
+    // T is the sample type stored in the file, float or int16_t.
+    template <typename T>
+    static WavWriter create(const std::string &path, uint32_t sample_rate, uint32_t channels) {
+        return WavWriter(path, sample_rate, channels, WavSampleMapping<T>::format);
+    }
+
+    WavWriter(const std::string &path, uint32_t sample_rate, uint32_t channels, int format) : channels_(channels) {
+        assert(channels > 0);
+        SF_INFO info = {0, static_cast<int>(sample_rate), static_cast<int>(channels), SF_FORMAT_WAV | format, 0, 0};
+        file_ = sf_open(path.c_str(), SFM_WRITE, &info);
+        if (file_ == nullptr) {
+            spdlog::error("Open file failed! target path: {}, error: {}", path, sf_strerror(nullptr));
+            return;
+        }
+        // Float samples out of range are clipped rather than wrapped in 16 bit files.
+        sf_command(file_, SFC_SET_CLIPPING, nullptr, SF_TRUE);
+    }
+
+    ~WavWriter() { close(); }
+
+    WavWriter(WavWriter &&other) noexcept
+        : channels_(other.channels_), frames_(other.frames_), file_(std::exchange(other.file_, nullptr)) {}
+    WavWriter(const WavWriter &) = delete;
+    WavWriter &operator=(const WavWriter &) = delete;
+
+    bool is_open() const { return file_ != nullptr; }
+
+    uint64_t frames() const { return frames_; }
+
+    // size interleaved samples, a whole number of frames. Float samples go into
+    // a 16 bit file scaled from [-1, 1].
+    template <typename T> bool write(const T *data, size_t size) {
+        assert(size % channels_ == 0);
+        if (file_ == nullptr) {
+            return false;
+        }
+        const auto frames = static_cast<sf_count_t>(size / channels_);
+        const auto count = WavSampleMapping<T>::write(file_, data, frames);
+        frames_ += count > 0 ? static_cast<uint64_t>(count) : 0;
+        if (count != frames) {
+            spdlog::error("Write wav failed, error: {}", sf_strerror(file_));
+            return false;
+        }
+        return true;
+    }
+
+    // Patches the sizes written so far into the header without closing.
+    void update_header() {
+        if (file_ != nullptr) {
+            sf_command(file_, SFC_UPDATE_HEADER_NOW, nullptr, 0);
+        }
+    }
 
-    auto count = WavSaveMapping<T>::function(outfile, data, size);
-    sf_close(outfile);
+    // Patches the sizes into the header and closes.
+    void close() {
+        if (file_ != nullptr) {
+            sf_close(file_);
+            file_ = nullptr;
+        }
+    }
 
-    return count == size;
+private:
+    uint32_t channels_{};
+    uint64_t frames_{};
+    SNDFILE *file_{};
+};
+
+template <typename T, typename std::enable_if_t<std::is_arithmetic_v<T>, void> * = nullptr>
+bool save_wav(const std::string &path, const T *data, size_t size, uint32_t sample_rate, uint32_t channels) {
+    auto writer = WavWriter::create<T>(path, sample_rate, channels);
+    return writer.write(data, size);
 }
 
 } // namespace utils
@@ -0,0 +1,192 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_UTILS_LOOKUP_H_
+#define INCLUDE_UTILS_LOOKUP_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace lisa {
+
+namespace utils {
+
+// Lookup tables meant to be built by constexpr initializers, so they live in
+// read-only data and cost nothing at startup. Building one from bad input (too
+// few pages, duplicate keys) throws, which fails the build in a constant context.
+
+// Set of ASCII characters as a 128 bit mask.
+class AsciiSet final {
+public:
+    constexpr explicit AsciiSet(std::string_view chars) {
+        for (const auto ch : chars) {
+            const auto code = static_cast<uint8_t>(ch);
+            if (code >= 128) {
+                throw "AsciiSet: not an ASCII character";
+            }
+            bits_[code >> 6] |= uint64_t{1} << (code & 63);
+        }
+    }
+
+    constexpr bool contains(char32_t ch) const { return ch < 128 && ((bits_[ch >> 6] >> (ch & 63)) & 1) != 0; }
+
+private:
+    std::array<uint64_t, 2> bits_{};
+};
+
+template <typename Value>
+struct CodePointEntry {
+    char32_t key;
+    Value value;
+};
+
+// Number of pages a CodePointMap over entries needs.
+template <typename Value, size_t N>
+constexpr size_t code_point_pages(const CodePointEntry<Value> (&entries)[N]) {
+    std::array<bool, 256> used{};
+    size_t count = 1;
+    for (const auto &entry : entries) {
+        if (!used[(entry.key >> 8) & 0xFF]) {
+            used[(entry.key >> 8) & 0xFF] = true;
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Maps code points of the basic multilingual plane to values through two levels:
+// the high byte selects a 256 entry page, the low byte the value in it. Absent
+// pages share page 0, see code_point_pages. Unmapped code points give Value{}.
+template <typename Value, size_t Pages>
+class CodePointMap final {
+public:
+    template <size_t N>
+    constexpr explicit CodePointMap(const CodePointEntry<Value> (&entries)[N]) {
+        size_t used = 0;
+        for (const auto &entry : entries) {
+            if (entry.key > 0xFFFF) {
+                throw "CodePointMap: code point outside the basic multilingual plane";
+            }
+            auto &page = index_[entry.key >> 8];
+            if (page == 0) {
+                if (++used >= Pages) {
+                    throw "CodePointMap: not enough pages";
+                }
+                page = static_cast<uint8_t>(used);
+            }
+            pages_[page][entry.key & 0xFF] = entry.value;
+        }
+    }
+
+    constexpr Value operator[](char32_t ch) const { return ch > 0xFFFF ? Value{} : pages_[index_[ch >> 8]][ch & 0xFF]; }
+
+private:
+    std::array<uint8_t, 256> index_{};
+    std::array<std::array<Value, 256>, Pages> pages_{};
+};
+
+template <typename Value>
+struct SymbolEntry {
+    std::string_view key;
+    Value value;
+};
+
+// Static string keyed map with a perfect hash built by hash and displace: keys
+// are grouped into buckets by a first hash and, largest bucket first, each bucket
+// searches a displacement that puts all its keys into free slots under a second
+// hash. A lookup is two hashes and one comparison.
+template <typename Value, size_t N>
+class PerfectHash final {
+public:
+    using Entry = SymbolEntry<Value>;
+
+    static constexpr size_t power_of_two(size_t n) {
+        size_t count = 1;
+        while (count < n) {
+            count *= 2;
+        }
+        return count;
+    }
+
+    static constexpr size_t SLOT_COUNT = power_of_two(N * 2);
+    static constexpr size_t BUCKET_COUNT = power_of_two((N + 1) / 2);
+
+    constexpr explicit PerfectHash(const Entry (&entries)[N]) {
+        std::array<size_t, BUCKET_COUNT> sizes{};
+        size_t max_size = 0;
+        for (auto i = 0U; i < N; ++i) {
+            entries_[i] = entries[i];
+            max_size = std::max(max_size, ++sizes[bucket(entries[i].key)]);
+        }
+        for (auto size = max_size; size > 0; --size) {
+            for (auto b = 0U; b < BUCKET_COUNT; ++b) {
+                if (sizes[b] == size) {
+                    place(b);
+                }
+            }
+        }
+    }
+
+    constexpr const Value *find(std::string_view key) const {
+        const auto slot = slots_[hash(key, displacements_[bucket(key)]) & (SLOT_COUNT - 1)];
+        return slot != 0 && entries_[slot - 1].key == key ? &entries_[slot - 1].value : nullptr;
+    }
+
+    constexpr const std::array<Entry, N> &entries() const { return entries_; }
+
+private:
+    static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+        uint32_t hash = 0x811C9DC5U ^ (seed * 0x9E3779B9U);
+        for (const auto ch : key) {
+            hash = (hash ^ static_cast<uint8_t>(ch)) * 0x01000193U;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    static constexpr size_t bucket(std::string_view key) { return hash(key, 0) & (BUCKET_COUNT - 1); }
+
+    constexpr void place(size_t b) {
+        for (uint32_t displacement = 1; displacement <= 0xFFFF; ++displacement) {
+            std::array<size_t, N> taken{};
+            size_t count = 0;
+            bool fits = true;
+            for (auto i = 0U; i < N && fits; ++i) {
+                if (bucket(entries_[i].key) != b) {
+                    continue;
+                }
+                const auto slot = hash(entries_[i].key, displacement) & (SLOT_COUNT - 1);
+                fits = slots_[slot] == 0;
+                for (auto j = 0U; j < count && fits; ++j) {
+                    fits = taken[j] != slot;
+                }
+                taken[count++] = slot;
+            }
+            if (!fits) {
+                continue;
+            }
+            count = 0;
+            for (auto i = 0U; i < N; ++i) {
+                if (bucket(entries_[i].key) == b) {
+                    slots_[taken[count++]] = static_cast<uint16_t>(i + 1);
+                }
+            }
+            displacements_[b] = displacement;
+            return;
+        }
+        throw "PerfectHash: no displacement found, duplicate keys?";
+    }
+
+    std::array<Entry, N> entries_{};
+    std::array<uint16_t, SLOT_COUNT> slots_{};
+    std::array<uint32_t, BUCKET_COUNT> displacements_{};
+};
+
+template <typename Value, size_t N>
+PerfectHash(const SymbolEntry<Value> (&)[N]) -> PerfectHash<Value, N>;
+
+} // namespace utils
+
+} // namespace lisa
+
+#endif
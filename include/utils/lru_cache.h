@@ -0,0 +1,132 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_UTILS_LRU_CACHE_H_
+#define INCLUDE_UTILS_LRU_CACHE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lisa {
+
+namespace utils {
+
+// Thread safe LRU cache split into independently locked shards. Each shard holds
+// at most capacity / shard_count entries, values are shared so a hit never copies
+// under the lock.
+template <typename K, typename V, typename Hash = std::hash<K>> class LruCache {
+public:
+    using Sizer = std::function<size_t(const K &, const V &)>;
+
+    struct Stats {
+        uint64_t hits{};
+        uint64_t misses{};
+        uint64_t evictions{};
+        size_t entries{};
+        size_t bytes{};
+    };
+
+    explicit LruCache(size_t capacity, size_t shard_count = 16, Sizer sizer = nullptr)
+        : sizer_(sizer ? std::move(sizer) : [](const K &, const V &) { return sizeof(K) + sizeof(V); }) {
+        shard_count = std::max<size_t>(shard_count, 1);
+        shard_capacity_ = std::max<size_t>(capacity / shard_count, 1);
+        for (auto i = 0U; i < shard_count; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    std::shared_ptr<const V> get(const K &key) {
+        auto &shard = get_shard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto iter = shard.index.find(key);
+        if (iter == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return iter->second->value;
+    }
+
+    std::shared_ptr<const V> put(const K &key, V value) {
+        auto entry = Entry{key, std::make_shared<const V>(std::move(value)), 0};
+        entry.bytes = sizer_(entry.key, *entry.value);
+        auto &shard = get_shard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto iter = shard.index.find(key);
+        if (iter != shard.index.end()) {
+            shard.bytes -= iter->second->bytes;
+            shard.entries.erase(iter->second);
+            shard.index.erase(iter);
+        }
+        shard.bytes += entry.bytes;
+        shard.entries.push_front(std::move(entry));
+        shard.index[key] = shard.entries.begin();
+        while (shard.entries.size() > shard_capacity_) {
+            shard.bytes -= shard.entries.back().bytes;
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return shard.entries.front().value;
+    }
+
+    // Drops every entry, values still held by callers stay valid.
+    void clear() {
+        for (auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->index.clear();
+            shard->entries.clear();
+            shard->bytes = 0;
+        }
+    }
+
+    Stats stats() const {
+        Stats result{hits_.load(), misses_.load(), evictions_.load(), 0, 0};
+        for (const auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            result.entries += shard->entries.size();
+            result.bytes += shard->bytes;
+        }
+        return result;
+    }
+
+private:
+    struct Entry {
+        K key;
+        std::shared_ptr<const V> value;
+        size_t bytes;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex{};
+        std::list<Entry> entries{};
+        std::unordered_map<K, typename std::list<Entry>::iterator, Hash> index{};
+        size_t bytes{};
+    };
+
+    Shard &get_shard(const K &key) { return *shards_[Hash{}(key) % shards_.size()]; }
+
+    LruCache(const LruCache &) = delete;
+    LruCache &operator=(const LruCache &) = delete;
+
+private:
+    Sizer sizer_{};
+    size_t shard_capacity_{};
+    std::vector<std::unique_ptr<Shard>> shards_{};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
+
+} // namespace utils
+
+} // namespace lisa
+
+#endif
@@ -4,25 +4,149 @@
 #define INCLUDE_UTILS_STRING_H_
 
 #include <algorithm>
-#include <codecvt>
-#include <locale>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace lisa {
 
 namespace utils {
 
-static inline std::wstring utf8_to_wstring(const std::string &text) {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-    return converter.from_bytes(text);
+// Length of the well formed UTF-8 sequence at text[pos] with its code point in ch,
+// 0 if it is malformed: truncated, overlong, a surrogate or past U+10FFFF.
+static inline size_t utf8_sequence(std::string_view text, size_t pos, char32_t &ch) {
+    const auto *p = reinterpret_cast<const uint8_t *>(text.data()) + pos;
+    const auto avail = text.size() - pos;
+    const auto continuation = [p](size_t i) { return (p[i] & 0xC0) == 0x80; };
+    if (p[0] < 0x80) {
+        ch = p[0];
+        return 1;
+    }
+    if (p[0] < 0xC2) {
+        return 0;
+    }
+    if (p[0] < 0xE0) {
+        if (avail < 2 || !continuation(1)) {
+            return 0;
+        }
+        ch = (char32_t{p[0] & 0x1FU} << 6) | (p[1] & 0x3FU);
+        return 2;
+    }
+    if (p[0] < 0xF0) {
+        if (avail < 3 || !continuation(1) || !continuation(2)) {
+            return 0;
+        }
+        ch = (char32_t{p[0] & 0x0FU} << 12) | (char32_t{p[1] & 0x3FU} << 6) | (p[2] & 0x3FU);
+        return ch < 0x800 || (ch >= 0xD800 && ch <= 0xDFFF) ? 0 : 3;
+    }
+    if (p[0] < 0xF5) {
+        if (avail < 4 || !continuation(1) || !continuation(2) || !continuation(3)) {
+            return 0;
+        }
+        ch = (char32_t{p[0] & 0x07U} << 18) | (char32_t{p[1] & 0x3FU} << 12) | (char32_t{p[2] & 0x3FU} << 6) |
+             (p[3] & 0x3FU);
+        return ch < 0x10000 || ch > 0x10FFFF ? 0 : 4;
+    }
+    return 0;
 }
 
-static inline std::string wstring_to_utf8(const std::wstring &text) {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-    return converter.to_bytes(text);
+// Decodes the code point starting at pos and moves pos past it. Malformed bytes
+// decode to themselves one at a time.
+static inline char32_t utf8_next(std::string_view text, size_t &pos) {
+    if (static_cast<uint8_t>(text[pos]) < 0x80) {
+        return static_cast<uint8_t>(text[pos++]);
+    }
+    char32_t ch = 0;
+    const auto length = utf8_sequence(text, pos, ch);
+    if (length == 0) {
+        return static_cast<uint8_t>(text[pos++]);
+    }
+    pos += length;
+    return ch;
 }
 
+// Appends the UTF-8 encoding of a valid code point.
+static inline void utf8_append(std::string &text, char32_t ch) {
+    if (ch < 0x80) {
+        text.push_back(static_cast<char>(ch));
+    } else if (ch < 0x800) {
+        const char bytes[] = {static_cast<char>(0xC0 | (ch >> 6)), static_cast<char>(0x80 | (ch & 0x3F))};
+        text.append(bytes, 2);
+    } else if (ch < 0x10000) {
+        const char bytes[] = {static_cast<char>(0xE0 | (ch >> 12)), static_cast<char>(0x80 | ((ch >> 6) & 0x3F)),
+                              static_cast<char>(0x80 | (ch & 0x3F))};
+        text.append(bytes, 3);
+    } else {
+        const char bytes[] = {static_cast<char>(0xF0 | (ch >> 18)), static_cast<char>(0x80 | ((ch >> 12) & 0x3F)),
+                              static_cast<char>(0x80 | ((ch >> 6) & 0x3F)), static_cast<char>(0x80 | (ch & 0x3F))};
+        text.append(bytes, 4);
+    }
+}
+
+// Forward range over the code points of a UTF-8 view, decoded as they are
+// visited with utf8_next. offset() is the byte position of the current one.
+class Utf8View {
+public:
+    class Iterator {
+    public:
+        Iterator(std::string_view text, size_t pos) : text_(text), pos_(pos), next_(pos) { decode(); }
+
+        char32_t operator*() const { return ch_; }
+
+        Iterator &operator++() {
+            pos_ = next_;
+            decode();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const { return pos_ == other.pos_; }
+        bool operator!=(const Iterator &other) const { return pos_ != other.pos_; }
+
+        size_t offset() const { return pos_; }
+        size_t length() const { return next_ - pos_; }
+
+    private:
+        void decode() {
+            if (pos_ < text_.size()) {
+                ch_ = utf8_next(text_, next_);
+            }
+        }
+
+        std::string_view text_{};
+        size_t pos_{};
+        size_t next_{};
+        char32_t ch_{};
+    };
+
+    explicit Utf8View(std::string_view text) : text_(text) {}
+
+    Iterator begin() const { return Iterator(text_, 0); }
+    Iterator end() const { return Iterator(text_, text_.size()); }
+
+private:
+    std::string_view text_{};
+};
+
+// Position of the first byte at or after pos that is not ASCII, text.size() if
+// there is none. Scans 16 bytes at a time where SSE2 is available.
+size_t ascii_span_end(std::string_view text, size_t pos = 0);
+
+// Whether tail starts with a lead byte announcing more bytes than it has left,
+// all of them continuation bytes. std::wstring_convert dropped such a tail
+// silently, which keeps streamed text with a split character usable.
+bool utf8_truncated_tail(std::string_view tail);
+
+// Validating conversions with an ASCII fast path, result is left empty and false
+// returned on malformed input. A sequence truncated by the end of the text is
+// dropped rather than rejected.
+bool utf8_decode(std::string_view text, std::wstring &result);
+bool utf8_encode(std::wstring_view text, std::string &result);
+
+// Throw std::range_error on malformed input, as std::wstring_convert did.
+std::wstring utf8_to_wstring(std::string_view text);
+std::string wstring_to_utf8(std::wstring_view text);
+
 std::vector<std::string> string_split_any(const std::string &str, const std::string &delim = " ");
 std::vector<std::string> string_split_all(const std::string &str, const std::string &delim = " ");
 
@@ -0,0 +1,59 @@
+// cute-giggle@outlook.com
+
+#ifndef INCLUDE_UTILS_THREAD_POOL_H_
+#define INCLUDE_UTILS_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace lisa {
+
+namespace utils {
+
+// Fixed size pool running tasks in submission order. A task may wait on tasks
+// submitted before it, never on later ones, or a small pool can deadlock.
+class ThreadPool final {
+public:
+    explicit ThreadPool(size_t thread_count);
+    ~ThreadPool();
+
+    template <typename F> std::future<std::invoke_result_t<F>> submit(F &&func) {
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace_back([task] { (*task)(); });
+        }
+        cv_.notify_one();
+        return future;
+    }
+
+    size_t size() const { return threads_.size(); }
+
+private:
+    void run();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+private:
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+    std::deque<std::function<void()>> tasks_{};
+    bool stopping_{false};
+    std::vector<std::thread> threads_{};
+};
+
+} // namespace utils
+
+} // namespace lisa
+
+#endif
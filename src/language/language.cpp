@@ -2,11 +2,16 @@
 
 #include "language/language.h"
 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
-#include <fstream>
+#include <iterator>
+#include <thread>
 
-#include "cppjieba/Jieba.hpp"
+#include "cppjieba/MixSegment.hpp"
+#include "language/symbol.h"
 #include "spdlog/spdlog.h"
+#include "utils/arena.h"
 #include "utils/string.h"
 #include "utils/time.h"
 #include "utils/type.h"
@@ -15,23 +20,62 @@ namespace lisa::language {
 
 namespace fs = std::filesystem;
 
-std::unique_ptr<cppjieba::Jieba> LanguageHelper::jieba_ = nullptr;
+// The subset of cppjieba::Jieba that tagging uses. Jieba itself also builds four
+// other segmenters and a keyword extractor that loads idf and stop word files.
+struct LanguageHelper::Segmenter {
+    std::unique_ptr<cppjieba::DictTrie> dict_trie;
+    std::unique_ptr<cppjieba::HMMModel> hmm_model;
+    cppjieba::MixSegment mix_segment;
+
+    Segmenter(std::unique_ptr<cppjieba::DictTrie> trie, std::unique_ptr<cppjieba::HMMModel> model)
+        : dict_trie(std::move(trie)), hmm_model(std::move(model)), mix_segment(dict_trie.get(), hmm_model.get()) {}
+};
+
+std::unique_ptr<LanguageHelper::Segmenter> LanguageHelper::segmenter_ = nullptr;
 
 LanguageHelper &LanguageHelper::instance() {
     static LanguageHelper instance;
     return instance;
 }
 
-LanguageHelper::LanguageHelper() {
-    get_jieba_dict_root();
-    initialize_jieba();
+std::shared_future<void> LanguageHelper::preload() { return instance().ready(); }
 
+// Only resolves the data roots, the dictionaries load on the startup pool and
+// every entry point waits for just the components it uses.
+LanguageHelper::LanguageHelper()
+    : pool_(std::make_unique<lisa::utils::ThreadPool>(
+          std::max<size_t>(STARTUP_THREAD_COUNT, std::thread::hardware_concurrency()))) {
+    const auto start = lisa::utils::current_ts_us();
+    get_jieba_dict_root();
     get_language_data_root();
-    get_unicode_pinyin_list();
-    get_chinese_pinyin_phone_mapper();
-    get_chinese_words_pinyin_mapper();
-    get_tagging_words_pinyin_mapper();
-    get_english_words_pinyin_mapper();
+
+    segmenter_ready_ = initialize_jieba();
+    lexicon_ready_ = pool_->submit([this] {
+                             auto lexicon = load_lexicon();
+                             assert(lexicon != nullptr);
+                             std::atomic_store(&lexicon_, std::move(lexicon));
+                         }).share();
+    // Submitted after the loads it waits for, see ThreadPool.
+    ready_ = pool_->submit([this, start] {
+                      segmenter_ready_.get();
+                      lexicon_ready_.get();
+                      spdlog::debug("Language helper ready, time cost: {} us", lisa::utils::current_ts_us() - start);
+                  }).share();
+}
+
+LanguageHelper::~LanguageHelper() {
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        watch_stopping_ = true;
+    }
+    watch_cv_.notify_all();
+    if (watcher_.joinable()) {
+        watcher_.join();
+    }
+}
+
+std::shared_future<void> LanguageHelper::ready(Component component) const {
+    return component == Component::SEGMENTER ? segmenter_ready_ : lexicon_ready_;
 }
 
 void LanguageHelper::get_jieba_dict_root() {
@@ -47,7 +91,7 @@ void LanguageHelper::get_jieba_dict_root() {
     assert(fs::exists(cppjieba_dict_root_));
 }
 
-void LanguageHelper::initialize_jieba() {
+std::shared_future<void> LanguageHelper::initialize_jieba() {
     std::vector<std::string> dict_paths;
     for (const auto &file_name : CPPJIEBA_DICT_FILE_NAME_LIST) {
         dict_paths.push_back(cppjieba_dict_root_ + "/" + file_name);
@@ -56,10 +100,22 @@ void LanguageHelper::initialize_jieba() {
         spdlog::debug("Cppjieba dict file path: [{}]", path);
         assert(fs::exists(path));
     }
-    const auto &pts = dict_paths;
-    const auto start = lisa::utils::current_ts_us();
-    LanguageHelper::jieba_ = std::make_unique<cppjieba::Jieba>(pts[0], pts[1], pts[2], pts[3], pts[4]);
-    spdlog::debug("Initialize cppjieba done, time cost: {} us", lisa::utils::current_ts_us() - start);
+    // The trie and the hmm model are independent, only the segment over them needs both.
+    auto hmm_model = pool_->submit([path = dict_paths[1]] {
+        const auto start = lisa::utils::current_ts_us();
+        auto model = std::make_unique<cppjieba::HMMModel>(path);
+        spdlog::debug("Loading cppjieba hmm model done, time cost: {} us", lisa::utils::current_ts_us() - start);
+        return model;
+    });
+    return pool_
+        ->submit([dict_path = dict_paths[0], user_dict_path = dict_paths[2], hmm_model = std::move(hmm_model)]() mutable {
+            const auto start = lisa::utils::current_ts_us();
+            auto dict_trie = std::make_unique<cppjieba::DictTrie>(dict_path, user_dict_path);
+            spdlog::debug("Loading cppjieba dict trie done, time cost: {} us", lisa::utils::current_ts_us() - start);
+            LanguageHelper::segmenter_ = std::make_unique<Segmenter>(std::move(dict_trie), hmm_model.get());
+            spdlog::debug("Initialize cppjieba done, time cost: {} us", lisa::utils::current_ts_us() - start);
+        })
+        .share();
 }
 
 void LanguageHelper::get_language_data_root() {
@@ -75,92 +131,224 @@ void LanguageHelper::get_language_data_root() {
     assert(fs::exists(language_data_root_));
 }
 
-void LanguageHelper::get_unicode_pinyin_list() {
-    auto unicode_pinyin_path = language_data_root_ + "/" + UNICODE_PINYIN_FILE_NAME;
-    spdlog::debug("Unicode pinyin file path: [{}]", unicode_pinyin_path);
-    assert(fs::exists(unicode_pinyin_path));
-    std::ifstream ifs(unicode_pinyin_path, std::ios::in);
-    assert(ifs.is_open());
-
-    std::string line;
+std::shared_ptr<const LanguageHelper::LexiconSnapshot> LanguageHelper::load_lexicon() const {
     const auto start = lisa::utils::current_ts_us();
-    while (std::getline(ifs, line)) {
-        unicode_pinyin_list_.push_back(line);
+    auto snapshot = std::make_shared<LexiconSnapshot>();
+    // Taken first, so sources changing while they are read are noticed again.
+    snapshot->fingerprint = Lexicon::fingerprint(language_data_root_);
+    snapshot->lexicon = Lexicon::load(language_data_root_);
+    if (snapshot->lexicon == nullptr) {
+        spdlog::warn("Lexicon image [{}] not usable, parse text sources instead", Lexicon::IMAGE_FILE_NAME);
+        snapshot->lexicon = Lexicon::compile(language_data_root_);
+        if (snapshot->lexicon == nullptr) {
+            return nullptr;
+        }
+    }
+
+    auto &symbol_table = SymbolTable::instance();
+    snapshot->symbol_ids.resize(snapshot->lexicon->symbol_count());
+    for (auto i = 0U; i < snapshot->symbol_ids.size(); ++i) {
+        snapshot->symbol_ids[i] = symbol_table.intern(snapshot->lexicon->symbol(i));
+    }
+    // Punctuation has no phones and is passed on as a symbol of its own.
+    for (auto ch = PRINTABLE_ASCII_BEGIN; ch <= PRINTABLE_ASCII_END; ++ch) {
+        snapshot->ascii_ids[ch] = symbol_table.intern(std::string_view(&ch, 1));
     }
-    spdlog::debug("Reading unicode pinyin file done, time cost: {} us", lisa::utils::current_ts_us() - start);
+    spdlog::debug("Loading lexicon done, time cost: {} us", lisa::utils::current_ts_us() - start);
+    return snapshot;
 }
 
-void LanguageHelper::get_chinese_pinyin_phone_mapper() {
-    auto chinese_pinyin_phone_mapper_path = language_data_root_ + "/" + CHINESE_PINYIN_PHONE_MAPPER_FILE_NAME;
-    spdlog::debug("Chinese pinyin phone mapper file path: [{}]", chinese_pinyin_phone_mapper_path);
-    assert(fs::exists(chinese_pinyin_phone_mapper_path));
-    std::ifstream ifs(chinese_pinyin_phone_mapper_path, std::ios::in);
-    assert(ifs.is_open());
+std::shared_ptr<const LanguageHelper::LexiconSnapshot> LanguageHelper::lexicon() const {
+    lexicon_ready_.get();
+    return std::atomic_load(&lexicon_);
+}
 
-    std::string line;
-    const auto start = lisa::utils::current_ts_us();
-    while (std::getline(ifs, line)) {
-        const auto pos = line.find_first_of(' ');
-        assert(pos != std::string::npos);
-        chinese_pinyin_phone_mapper_[line.substr(0, pos)] = line.substr(pos + 1);
+uint64_t LanguageHelper::lexicon_hash() const { return lexicon()->lexicon->content_hash(); }
+
+// Readers hold the snapshot they started with, the old one goes away with the
+// last of them.
+std::shared_future<bool> LanguageHelper::reload() {
+    return pool_
+        ->submit([this] {
+            lexicon_ready_.get();
+            std::lock_guard<std::mutex> lock(reload_mutex_);
+            const auto start = lisa::utils::current_ts_us();
+            auto lexicon = load_lexicon();
+            if (lexicon == nullptr) {
+                spdlog::error("Reload lexicon failed, keep the current one, data root: {}", language_data_root_);
+                return false;
+            }
+            std::atomic_store(&lexicon_, std::move(lexicon));
+            spdlog::info("Reload lexicon done, time cost: {} us", lisa::utils::current_ts_us() - start);
+            return true;
+        })
+        .share();
+}
+
+void LanguageHelper::watch(std::chrono::milliseconds interval) {
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        watch_interval_ = interval;
+        if (!watcher_.joinable() && interval.count() > 0) {
+            watcher_ = std::thread([this] { watch_sources(); });
+        }
+    }
+    watch_cv_.notify_all();
+}
+
+// A changed fingerprint has to hold for one interval before it is reloaded, so
+// a source still being written is not picked up half way. Sources a reload
+// failed on are left alone until they change again.
+void LanguageHelper::watch_sources() {
+    lexicon_ready_.get();
+    uint64_t pending = 0;
+    uint64_t attempted = 0;
+    std::unique_lock<std::mutex> lock(watch_mutex_);
+    while (true) {
+        if (watch_interval_.count() == 0) {
+            watch_cv_.wait(lock, [this] { return watch_stopping_ || watch_interval_.count() > 0; });
+            pending = 0;
+        } else {
+            watch_cv_.wait_for(lock, watch_interval_, [this] { return watch_stopping_; });
+        }
+        if (watch_stopping_) {
+            return;
+        }
+        if (watch_interval_.count() == 0) {
+            continue;
+        }
+        lock.unlock();
+        const auto fingerprint = Lexicon::fingerprint(language_data_root_);
+        if (fingerprint == 0 || fingerprint == std::atomic_load(&lexicon_)->fingerprint || fingerprint == attempted) {
+            pending = 0;
+        } else if (fingerprint != pending) {
+            pending = fingerprint;
+        } else {
+            spdlog::info("Lexicon sources changed, reload, data root: {}", language_data_root_);
+            attempted = fingerprint;
+            pending = 0;
+            reload().get();
+        }
+        lock.lock();
     }
-    spdlog::debug("Reading Chinese pinyin phone mapper file done, time cost: {} us", lisa::utils::current_ts_us() - start);
 }
 
-void LanguageHelper::get_chinese_words_pinyin_mapper() {
-    auto chinese_words_pinyin_mapper_path = language_data_root_ + "/" + CHINESE_WORDS_PINYIN_MAPPER_FILE_NAME;
-    spdlog::debug("Chinese words pinyin mapper file path: [{}]", chinese_words_pinyin_mapper_path);
-    assert(fs::exists(chinese_words_pinyin_mapper_path));
-    std::ifstream ifs(chinese_words_pinyin_mapper_path, std::ios::in);
-    assert(ifs.is_open());
+// ASCII is cut the way cppjieba's HMM segment cuts it: a letter followed by letters
+// and digits, a digit followed by digits and dots, any other character alone.
+static bool is_ascii_alnum(char ch) { return isalnum(static_cast<uint8_t>(ch)) != 0; }
 
-    std::string line;
-    const auto start = lisa::utils::current_ts_us();
-    while (std::getline(ifs, line)) {
-        const auto pos = line.find_first_of(' ');
-        assert(pos != std::string::npos);
-        chinese_words_pinyin_mapper_[line.substr(0, pos)] = line.substr(pos + 1);
+static size_t ascii_word_end(std::string_view text, size_t pos) {
+    const auto ch = text[pos++];
+    if (isalpha(static_cast<uint8_t>(ch))) {
+        while (pos < text.size() && is_ascii_alnum(text[pos])) {
+            ++pos;
+        }
+    } else if (isdigit(static_cast<uint8_t>(ch))) {
+        while (pos < text.size() && (isdigit(static_cast<uint8_t>(text[pos])) || text[pos] == '.')) {
+            ++pos;
+        }
     }
-    spdlog::debug("Reading chinese words pinyin mapper file done, time cost: {} us", lisa::utils::current_ts_us() - start);
+    return pos;
 }
 
-void LanguageHelper::get_tagging_words_pinyin_mapper() {
-    auto tagging_words_pinyin_mapper_path = language_data_root_ + "/" + TAGGING_WORDS_PINYIN_MAPPER_FILE_NAME;
-    spdlog::debug("Tagging words pinyin mapper file path: [{}]", tagging_words_pinyin_mapper_path);
-    assert(fs::exists(tagging_words_pinyin_mapper_path));
-    std::ifstream ifs(tagging_words_pinyin_mapper_path, std::ios::in);
-    assert(ifs.is_open());
+// cppjieba's PosTagger::SpecialRule, the tag of a word missing from its dictionary:
+// decided by the first half of the word, "m" if all digits, "x" for one character.
+static const char *ascii_word_tag(std::string_view word) {
+    const auto half = word.size() / 2;
+    if (half == 0) {
+        return "x";
+    }
+    const auto is_digit = [](char ch) { return isdigit(static_cast<uint8_t>(ch)) != 0; };
+    return std::all_of(word.begin(), word.begin() + half, is_digit) ? "m" : "eng";
+}
 
-    std::string line;
-    const auto start = lisa::utils::current_ts_us();
-    while (std::getline(ifs, line)) {
-        const auto pos = line.find_first_of(' ');
-        assert(pos != std::string::npos);
-        tagging_words_pinyin_mapper_[line.substr(0, pos)] = line.substr(pos + 1);
+static void ascii_tokenize(std::string_view text, std::pmr::vector<std::pair<std::string_view, std::string_view>> &result) {
+    for (size_t pos = 0; pos < text.size();) {
+        const auto end = ascii_word_end(text, pos);
+        const auto word = text.substr(pos, end - pos);
+        result.emplace_back(word, ascii_word_tag(word));
+        pos = end;
     }
-    spdlog::debug("Reading tagging words pinyin mapper file done, time cost: {} us", lisa::utils::current_ts_us() - start);
 }
 
-void LanguageHelper::get_english_words_pinyin_mapper() {
-    auto english_words_pinyin_mapper_path = language_data_root_ + "/" + ENGLISH_WORDS_PINYIN_MAPPER_FILE_NAME;
-    spdlog::debug("English words pinyin mapper file path: [{}]", english_words_pinyin_mapper_path);
-    assert(fs::exists(english_words_pinyin_mapper_path));
-    std::ifstream ifs(english_words_pinyin_mapper_path, std::ios::in);
-    assert(ifs.is_open());
+// A span handed to cppjieba starts with the letters and digits glued to its
+// first non ASCII character, so dictionary words like "卡拉OK" stay whole, and
+// runs on over separators until the ASCII after one holds a word of its own.
+// cppjieba cuts at ASCII separators itself, so nothing changes across a cut.
+// ASCII words of its dictionary are the exception, they are tagged as above.
+// ASCII tokens view into the sentence, what cppjieba returns is copied to the
+// arena of result.
+void LanguageHelper::segment(std::string_view sentence, TokenList &result) const {
+    // cppjieba only takes strings, reused across calls on the same thread.
+    thread_local std::string span;
+    thread_local std::vector<Token> tokens;
+    auto *arena = result.get_allocator().resource();
+    size_t pos = 0;
+    while (pos < sentence.size()) {
+        const auto ascii_end = lisa::utils::ascii_span_end(sentence, pos);
+        auto begin = ascii_end;
+        if (ascii_end != sentence.size()) {
+            while (begin > pos && is_ascii_alnum(sentence[begin - 1])) {
+                --begin;
+            }
+        }
+        ascii_tokenize(sentence.substr(pos, begin - pos), result);
+        if (begin == sentence.size()) {
+            break;
+        }
 
-    std::string line;
-    const auto start = lisa::utils::current_ts_us();
-    while (std::getline(ifs, line)) {
-        const auto pos = line.find_first_of("  ");
-        assert(pos != std::string::npos);
-        english_words_pinyin_mapper_[line.substr(0, pos)] = line.substr(pos + 2);
+        auto end = ascii_end;
+        while (end < sentence.size()) {
+            while (end < sentence.size() && static_cast<uint8_t>(sentence[end]) >= 0x80) {
+                ++end;
+            }
+            while (end < sentence.size() && is_ascii_alnum(sentence[end])) {
+                ++end;
+            }
+            if (end == sentence.size() || static_cast<uint8_t>(sentence[end]) >= 0x80) {
+                continue;
+            }
+            // At a separator, look for a word not glued to the next non ASCII character.
+            const auto next = lisa::utils::ascii_span_end(sentence, end);
+            auto glued = next;
+            if (next != sentence.size()) {
+                while (glued > end && is_ascii_alnum(sentence[glued - 1])) {
+                    --glued;
+                }
+            }
+            if (std::any_of(sentence.begin() + end, sentence.begin() + glued, is_ascii_alnum)) {
+                break;
+            }
+            end = next;
+        }
+
+        segmenter_ready_.get();
+        span.assign(sentence.substr(begin, end - begin));
+        tokens.clear();
+        segmenter_->mix_segment.Tag(span, tokens);
+        for (const auto &[word, tag] : tokens) {
+            result.emplace_back(lisa::utils::copy(word, arena), lisa::utils::copy(tag, arena));
+        }
+        pos = end;
     }
-    spdlog::debug("Reading english words pinyin mapper file done, time cost: {} us", lisa::utils::current_ts_us() - start);
 }
 
+// Waits for the segmenter only if the sentence has non ASCII text.
 std::vector<Token> LanguageHelper::tokenize(const std::string &sentence) const {
+    lisa::utils::Arena arena;
+    TokenList tokens(arena.resource());
+    tokenize(sentence, tokens);
+
     std::vector<Token> result;
-    jieba_->Tag(sentence, result);
+    result.reserve(tokens.size());
+    for (const auto &[word, tag] : tokens) {
+        result.emplace_back(word, tag);
+    }
+    return result;
+}
+
+void LanguageHelper::tokenize(std::string_view sentence, TokenList &result) const {
+    segment(sentence, result);
 
     for (auto &word : result) {
         if (word.second == "x" && word.first.size() == 1 && isalpha(word.first[0])) {
@@ -168,146 +356,226 @@ std::vector<Token> LanguageHelper::tokenize(const std::string &sentence) const {
         }
     }
 
+    // Drops the spaces between english words in place, the ends always stay.
     if (result.size() >= 3) {
-        std::vector<Token> temp{result.front()};
+        auto previous_eng = result.front().second == "eng";
+        auto kept = 1U;
         for (auto i = 1U; i < result.size() - 1; ++i) {
-            if (result[i].first == " " && result[i - 1].second == "eng" && result[i + 1].second == "eng") {
+            const auto eng = result[i].second == "eng";
+            const auto drop = result[i].first == " " && previous_eng && result[i + 1].second == "eng";
+            previous_eng = eng;
+            if (drop) {
                 continue;
             }
-            temp.emplace_back(result[i]);
+            if (kept != i) {
+                result[kept] = std::move(result[i]);
+            }
+            ++kept;
         }
-        temp.emplace_back(result.back());
-        std::swap(temp, result);
+        if (kept != result.size() - 1) {
+            result[kept] = std::move(result.back());
+        }
+        result.resize(kept + 1);
     }
 
-    std::string logstr = "";
-    for (const auto &pr : result) {
-        logstr += spdlog::fmt_lib::format("({}|{})", pr.first, pr.second);
+    if (spdlog::should_log(spdlog::level::debug)) {
+        std::pmr::string logstr(result.get_allocator().resource());
+        for (const auto &pr : result) {
+            spdlog::fmt_lib::format_to(std::back_inserter(logstr), "({}|{})", pr.first, pr.second);
+        }
+        spdlog::debug("Tokenize result: [{}]", logstr);
     }
-    spdlog::debug("Tokenize result: [{}]", logstr);
-
-    return result;
 }
 
 std::vector<Pronounce> LanguageHelper::pronounce(const std::string &sentence) const {
+    std::vector<PronounceId> pronounces;
+    pronounce(sentence, pronounces);
+
+    const auto &symbol_table = SymbolTable::instance();
     std::vector<Pronounce> result;
-    auto words = tokenize(sentence);
+    result.reserve(pronounces.size());
+    for (const auto &[phone, tone, lang] : pronounces) {
+        result.emplace_back(Pronounce{std::string(symbol_table.name(phone)), tone, lang});
+    }
+    return result;
+}
+
+// Safe to run concurrently: the segmenter and the lexicon are only read once
+// loaded, the symbol table locks, and the scratch buffers are per call.
+void LanguageHelper::pronounce(std::string_view sentence, std::vector<PronounceId> &result,
+                               std::pmr::memory_resource *arena) const {
+    if (arena != nullptr) {
+        pronounce(*lexicon(), sentence, result, arena);
+        return;
+    }
+    lisa::utils::Arena own_arena;
+    pronounce(*lexicon(), sentence, result, own_arena.resource());
+}
 
-    std::vector<Token> adjusted_words;
+void LanguageHelper::pronounce(const LexiconSnapshot &lexicon, std::string_view sentence,
+                               std::vector<PronounceId> &result, std::pmr::memory_resource *arena) const {
+    const auto first = result.size();
+    TokenList words(arena);
+    tokenize(sentence, words);
+
+    // Capitals are spelled letter by letter, "AI" as "A." and "I.".
+    TokenList adjusted_words(arena);
+    adjusted_words.reserve(words.size());
     for (const auto &word : words) {
         if (word.second == "eng" && std::all_of(word.first.begin(), word.first.end(), isupper)) {
             for (const auto ch : word.first) {
-                Token token{std::string(1, ch) + '.', "eng"};
-                adjusted_words.push_back(std::move(token));
+                const char letter[] = {ch, '.'};
+                adjusted_words.emplace_back(lisa::utils::copy({letter, sizeof(letter)}, arena), "eng");
             }
             continue;
         }
         adjusted_words.push_back(word);
     }
-    std::swap(words, adjusted_words);
 
-    std::string pinyin_logstr = "";
+    std::pmr::vector<Syllable> syllables(arena);
+    // Only built when it is logged.
+    const auto log_pinyin = spdlog::should_log(spdlog::level::debug);
+    std::pmr::string pinyin_logstr(arena);
 
-    for (const auto &word : words) {
+    for (const auto &word : adjusted_words) {
         // if (word.second == "x") {
         //     result.emplace_back(Pronounce{word.first, 0, Language::NO});
         //     continue;
         // }
         if (word.second == "eng") {
-            auto pinyin_list = english_pinyin(word);
-            if (!pinyin_list.empty()) {
-                for (const auto &pinyin : pinyin_list) {
-                    const auto pronounces = english_pronounce(pinyin);
-                    result.insert(result.end(), pronounces.begin(), pronounces.end());
+            const auto pinyin_list = english_pinyin(lexicon, word);
+            if (pinyin_list && pinyin_list->size() > 0) {
+                for (auto i = 0U; i < pinyin_list->size(); ++i) {
+                    english_pronounce(lexicon, *pinyin_list, i, result);
                 }
-                for (const auto &pinyin : pinyin_list) {
-                    pinyin_logstr += spdlog::fmt_lib::format("({})", pinyin);
+                for (auto i = 0U; log_pinyin && i < pinyin_list->size(); ++i) {
+                    spdlog::fmt_lib::format_to(std::back_inserter(pinyin_logstr), "({})", (*pinyin_list)[i]);
                 }
                 continue;
             }
         }
-        const auto pinyin_list = chinese_pinyin(word);
-        for (const auto &pinyin : pinyin_list) {
-            pinyin_logstr += spdlog::fmt_lib::format("({})", pinyin);
+        syllables.clear();
+        chinese_pinyin(lexicon, word, syllables);
+        for (auto i = 0U; log_pinyin && i < syllables.size(); ++i) {
+            spdlog::fmt_lib::format_to(std::back_inserter(pinyin_logstr), "({}{})", syllables[i].pinyin,
+                                       syllables[i].tone);
+        }
+        for (const auto &syllable : syllables) {
+            chinese_pronounce(lexicon, syllable, result);
         }
-        for (const auto &pinyin : pinyin_list) {
-            const auto pronounces = chinese_pronounce(pinyin);
-            result.insert(result.end(), pronounces.begin(), pronounces.end());
+    }
+
+    if (log_pinyin) {
+        spdlog::debug("Pinyin result: [{}]", pinyin_logstr);
+        std::pmr::string pronounce_logstr(arena);
+        for (auto i = first; i < result.size(); ++i) {
+            const auto &[phone, tone, lang] = result[i];
+            spdlog::fmt_lib::format_to(std::back_inserter(pronounce_logstr), "({}|{}|{})",
+                                       SymbolTable::instance().name(phone), tone, lisa::utils::to_underlying(lang));
         }
+        spdlog::debug("Pronounce result: [{}]", pronounce_logstr);
     }
+}
 
-    spdlog::debug("Pinyin result: [{}]", pinyin_logstr);
-    std::string pronounce_logstr = "";
-    for (const auto &[phone, tone, lang] : result) {
-        pronounce_logstr += spdlog::fmt_lib::format("({}|{}|{})", phone, tone, lisa::utils::to_underlying(lang));
+std::vector<std::vector<PronounceId>> LanguageHelper::pronounce_batch(const std::vector<std::string> &sentences,
+                                                                      size_t max_workers) const {
+    std::vector<std::vector<PronounceId>> result(sentences.size());
+    if (sentences.empty()) {
+        return result;
     }
-    spdlog::debug("Pronounce result: [{}]", pronounce_logstr);
+    // One snapshot for the whole batch, a reload in between does not mix tables.
+    const auto lexicon = this->lexicon();
+    segmenter_ready_.get();
 
+    const auto start = lisa::utils::current_ts_us();
+    auto workers = max_workers == 0 ? worker_count() : std::min(max_workers, worker_count());
+    workers = std::min(workers, sentences.size());
+    // Sentences are claimed one at a time, so a few long ones do not hold back a
+    // whole slice. Every slot of result is written by exactly one worker, with
+    // an arena of its own emptied after each sentence.
+    std::atomic<size_t> next{0};
+    const auto work = [&] {
+        lisa::utils::Arena arena;
+        for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < sentences.size();
+             i = next.fetch_add(1, std::memory_order_relaxed)) {
+            pronounce(*lexicon, sentences[i], result[i], arena.resource());
+            arena.release();
+        }
+    };
+    std::vector<std::future<void>> futures;
+    futures.reserve(workers - 1);
+    for (auto i = 1U; i < workers; ++i) {
+        futures.emplace_back(pool_->submit(work));
+    }
+    work();
+    for (auto &future : futures) {
+        future.get();
+    }
+    spdlog::debug("Pronounce batch of {} sentences on {} workers, time cost: {} us", sentences.size(), workers,
+                  lisa::utils::current_ts_us() - start);
     return result;
 }
 
-std::vector<std::string> LanguageHelper::chinese_pinyin(const Token &word) const {
-    const auto citer = chinese_words_pinyin_mapper_.find(word.first);
-    if (citer != chinese_words_pinyin_mapper_.end()) {
-        return lisa::utils::string_split_any(citer->second, " ");
+// Lexicon syllables carry their tone as a trailing digit, e.g. "zhong1".
+static LanguageHelper::Syllable to_syllable(std::string_view pinyin) {
+    return {pinyin.substr(0, pinyin.size() - 1), static_cast<uint32_t>(pinyin.back() - '0')};
+}
+
+void LanguageHelper::chinese_pinyin(const LexiconSnapshot &lexicon, const TokenView &word,
+                                    std::pmr::vector<Syllable> &result) const {
+    auto value = lexicon.lexicon->find(LexiconTable::CHINESE_WORDS_PINYIN, word.first);
+    if (!value) {
+        value = lexicon.lexicon->find(LexiconTable::TAGGING_WORDS_PINYIN, {word.first, "|", word.second});
     }
-    const auto word_tag_str = word.first + "|" + word.second;
-    const auto titer = tagging_words_pinyin_mapper_.find(word_tag_str);
-    if (titer != tagging_words_pinyin_mapper_.end()) {
-        return lisa::utils::string_split_any(titer->second, " ");
+    if (value) {
+        for (auto i = 0U; i < value->size(); ++i) {
+            result.emplace_back(to_syllable((*value)[i]));
+        }
+        return;
     }
-    std::vector<std::string> result;
-    const auto wword = utils::utf8_to_wstring(word.first);
-    for (const auto &ch : wword) {
+    const auto text = word.first;
+    const lisa::utils::Utf8View view(text);
+    for (auto iter = view.begin(); iter != view.end(); ++iter) {
+        const auto ch = *iter;
         if (ch < CHINESE_UNICODE_BEGIN || ch > CHINESE_UNICODE_END) {
-            result.emplace_back(utils::wstring_to_utf8(std::wstring(1, ch) + L'0'));
+            result.emplace_back(Syllable{text.substr(iter.offset(), iter.length()), 0});
             continue;
         }
         const auto index = ch - CHINESE_UNICODE_BEGIN;
-        result.emplace_back(unicode_pinyin_list_[index]);
+        result.emplace_back(to_syllable(lexicon.lexicon->value(LexiconTable::UNICODE_PINYIN, index)));
     }
-    return result;
 }
 
-std::vector<std::string> LanguageHelper::english_pinyin(const Token &token) const {
-    const auto word = lisa::utils::string_toupper(token.first);
-    const auto iter = english_words_pinyin_mapper_.find(word);
-    if (iter == english_words_pinyin_mapper_.end()) {
-        return {};
-    }
-    return lisa::utils::string_split_all(iter->second, " - ");
+std::optional<LexiconValue> LanguageHelper::english_pinyin(const LexiconSnapshot &lexicon, const TokenView &token) const {
+    return lexicon.lexicon->find(LexiconTable::ENGLISH_WORDS_PINYIN, token.first, true);
 }
 
-std::vector<Pronounce> LanguageHelper::chinese_pronounce(const std::string &pinyin_str) const {
-    const uint32_t tone = pinyin_str.back() - '0';
-    const auto pinyin = pinyin_str.substr(0, pinyin_str.size() - 1);
-    const auto iter = chinese_pinyin_phone_mapper_.find(pinyin);
-    if (iter == chinese_pinyin_phone_mapper_.end()) {
+void LanguageHelper::chinese_pronounce(const LexiconSnapshot &lexicon, const Syllable &syllable,
+                                       std::vector<PronounceId> &result) const {
+    const auto &[pinyin, tone] = syllable;
+    const auto value = lexicon.lexicon->find(LexiconTable::CHINESE_PINYIN_PHONE, pinyin);
+    if (!value) {
         spdlog::trace("Pinyin [{}] not found in phone mapper", pinyin);
-        return {Pronounce{pinyin, tone, Language::ZH}};
+        const auto printable = pinyin.size() == 1 && pinyin[0] >= PRINTABLE_ASCII_BEGIN && pinyin[0] <= PRINTABLE_ASCII_END;
+        const auto symbol = printable ? lexicon.ascii_ids[pinyin[0]] : SymbolTable::instance().intern(pinyin);
+        result.emplace_back(PronounceId{symbol, tone, Language::ZH});
+        return;
+    }
+    assert(value->size() == 2);
+    for (auto i = 0U; i < value->size(); ++i) {
+        const auto [begin, end] = value->phones(i);
+        for (auto phone = begin; phone != end; ++phone) {
+            result.emplace_back(PronounceId{lexicon.symbol_ids[phone->symbol], tone, Language::ZH});
+        }
     }
-    std::vector<Pronounce> result;
-    const auto phone_str = iter->second;
-    const auto pos = phone_str.find_first_of(' ');
-    assert(pos != std::string::npos);
-    result.emplace_back(Pronounce{phone_str.substr(0, pos), tone, Language::ZH});
-    result.emplace_back(Pronounce{phone_str.substr(pos + 1), tone, Language::ZH});
-    return result;
 }
 
-std::vector<Pronounce> LanguageHelper::english_pronounce(const std::string &pinyin) const {
-    std::vector<Pronounce> result;
-    auto phone_list = lisa::utils::string_split_any(pinyin, " ");
-    for (auto &phone : phone_list) {
-        uint32_t tone = 0;
-        if (isdigit(phone.back())) {
-            tone = phone.back() - '0' + 1;
-            phone.pop_back();
-        }
-        phone = lisa::utils::string_tolower(phone);
-        result.emplace_back(Pronounce{std::move(phone), tone, Language::EN});
+void LanguageHelper::english_pronounce(const LexiconSnapshot &lexicon, const LexiconValue &value, size_t index,
+                                       std::vector<PronounceId> &result) const {
+    const auto [begin, end] = value.phones(index);
+    for (auto phone = begin; phone != end; ++phone) {
+        result.emplace_back(PronounceId{lexicon.symbol_ids[phone->symbol], phone->tone, Language::EN});
     }
-    return result;
 }
 
 } // namespace doge::language
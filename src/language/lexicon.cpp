@@ -0,0 +1,488 @@
+// cute-giggle@outlook.com
+
+#include "language/lexicon.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+namespace lisa::language {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr auto TABLE_COUNT = static_cast<size_t>(LexiconTable::COUNT);
+constexpr auto ITEM_FIELDS = LexiconValue::ITEM_FIELDS;
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+// How every text source is laid out: list files are indexed by line number,
+// keyed files hold "key<sep>value" with a separator of value_skip bytes. Values
+// are split on item_delim into their items, empty items dropped. Items of the
+// phone tables are resolved to phone symbols as well: a chinese item is one phone
+// as is, an english item is a syllable of space separated, stress marked phones.
+enum class PhoneStyle { NONE, CHINESE, ENGLISH };
+
+struct TableSource {
+    bool keyed;
+    size_t value_skip;
+    std::string_view item_delim;
+    PhoneStyle phone_style;
+};
+
+constexpr TableSource TABLE_SOURCE_LIST[TABLE_COUNT] = {
+    {false, 0, "", PhoneStyle::NONE},       {true, 1, " ", PhoneStyle::CHINESE}, {true, 1, " ", PhoneStyle::NONE},
+    {true, 1, " ", PhoneStyle::NONE},       {true, 2, " - ", PhoneStyle::ENGLISH},
+};
+
+inline char fold_case(char ch) { return ch >= 'a' && ch <= 'z' ? static_cast<char>(ch - 'a' + 'A') : ch; }
+
+// Keys are hashed case folded so one index serves exact and case insensitive lookups.
+inline uint64_t hash_key(uint64_t hash, std::string_view key) {
+    for (const auto ch : key) {
+        hash = (hash ^ static_cast<uint8_t>(fold_case(ch))) * FNV_PRIME;
+    }
+    return hash;
+}
+
+bool key_equals(std::string_view key, const std::string_view *parts, size_t count, bool ignore_case) {
+    for (auto i = 0U; i < count; ++i) {
+        const auto part = parts[i];
+        if (ignore_case) {
+            for (auto j = 0U; j < part.size(); ++j) {
+                if (fold_case(key[j]) != fold_case(part[j])) {
+                    return false;
+                }
+            }
+        } else if (key.compare(0, part.size(), part) != 0) {
+            return false;
+        }
+        key.remove_prefix(part.size());
+    }
+    return true;
+}
+
+bool read_file(const std::string &path, std::string &content) {
+    std::ifstream ifs(path, std::ios::in | std::ios::binary);
+    if (!ifs.is_open()) {
+        return false;
+    }
+    content.resize(fs::file_size(path));
+    return static_cast<bool>(ifs.read(content.data(), content.size()));
+}
+
+} // namespace
+
+Lexicon::~Lexicon() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, size_);
+    }
+}
+
+std::unique_ptr<Lexicon> Lexicon::load(const std::string &data_root) {
+    const auto image_path = data_root + "/" + IMAGE_FILE_NAME;
+    if (!fs::exists(image_path)) {
+        return nullptr;
+    }
+
+    const auto start = lisa::utils::current_ts_us();
+    const auto fd = open(image_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        spdlog::error("Open lexicon image failed! target path: {}", image_path);
+        return nullptr;
+    }
+    struct stat st {};
+    const auto mapping = fstat(fd, &st) == 0 && st.st_size > 0
+                             ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)
+                             : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        spdlog::error("Map lexicon image failed! target path: {}", image_path);
+        return nullptr;
+    }
+
+    auto lexicon = std::unique_ptr<Lexicon>(new Lexicon());
+    lexicon->mapping_ = mapping;
+    lexicon->data_ = static_cast<const uint8_t *>(mapping);
+    lexicon->size_ = st.st_size;
+    if (!lexicon->validate()) {
+        spdlog::warn("Lexicon image invalid or of another version, ignored: {}", image_path);
+        return nullptr;
+    }
+    // Without the text sources the image is all there is, otherwise they win.
+    const auto source_fingerprint = fingerprint(data_root);
+    if (source_fingerprint != 0 && source_fingerprint != lexicon->header().fingerprint) {
+        spdlog::warn("Lexicon image out of date with its text sources, ignored: {}", image_path);
+        return nullptr;
+    }
+    spdlog::debug("Mapping lexicon image done, time cost: {} us", lisa::utils::current_ts_us() - start);
+    return lexicon;
+}
+
+std::unique_ptr<Lexicon> Lexicon::compile(const std::string &data_root) {
+    auto lexicon = std::unique_ptr<Lexicon>(new Lexicon());
+    lexicon->buffer_ = build(data_root);
+    lexicon->data_ = lexicon->buffer_.data();
+    lexicon->size_ = lexicon->buffer_.size();
+    if (!lexicon->validate()) {
+        spdlog::error("Compile lexicon failed, data root: {}", data_root);
+        return nullptr;
+    }
+    return lexicon;
+}
+
+bool Lexicon::save(const std::string &data_root, const std::string &image_path) {
+    const auto image = build(data_root);
+    if (image.empty()) {
+        return false;
+    }
+    const auto temp_path = image_path + ".tmp";
+    {
+        std::ofstream ofs(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open() || !ofs.write(reinterpret_cast<const char *>(image.data()), image.size())) {
+            spdlog::error("Write lexicon image failed! target path: {}", temp_path);
+            return false;
+        }
+    }
+    fs::rename(temp_path, image_path);
+    return true;
+}
+
+size_t Lexicon::size(LexiconTable table) const { return header().tables[static_cast<size_t>(table)].count; }
+
+std::string_view Lexicon::key(LexiconTable table, size_t index) const {
+    assert(index < size(table));
+    const auto &entry = entries(table)[index];
+    return pool(entry.key_offset, entry.key_size);
+}
+
+std::string_view Lexicon::value(LexiconTable table, size_t index) const {
+    assert(index < size(table));
+    const auto &entry = entries(table)[index];
+    return pool(entry.value_offset, entry.value_size);
+}
+
+std::string_view Lexicon::symbol(size_t index) const {
+    assert(index < symbol_count());
+    const auto symbols = reinterpret_cast<const uint32_t *>(data_ + header().symbol_offset);
+    return pool(symbols[index * 2], symbols[index * 2 + 1]);
+}
+
+std::optional<LexiconValue> Lexicon::find(LexiconTable table, const std::string_view *parts, size_t count,
+                                          bool ignore_case) const {
+    const auto &table_header = header().tables[static_cast<size_t>(table)];
+    if (table_header.slot_count == 0) {
+        return std::nullopt;
+    }
+    uint64_t hash = FNV_OFFSET_BASIS;
+    size_t key_size = 0;
+    for (auto i = 0U; i < count; ++i) {
+        hash = hash_key(hash, parts[i]);
+        key_size += parts[i].size();
+    }
+
+    const auto slots = reinterpret_cast<const uint32_t *>(data_ + table_header.slot_offset);
+    const auto mask = table_header.slot_count - 1;
+    for (auto slot = hash & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+        const auto &entry = entries(table)[slots[slot] - 1];
+        if (entry.key_size == key_size && key_equals(pool(entry.key_offset, entry.key_size), parts, count, ignore_case)) {
+            return items(entry);
+        }
+    }
+    return std::nullopt;
+}
+
+uint64_t Lexicon::fingerprint(const std::string &data_root) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (const auto &file_name : SOURCE_FILE_NAME_LIST) {
+        const auto path = data_root + "/" + file_name;
+        std::error_code ec;
+        const uint64_t values[] = {
+            static_cast<uint64_t>(fs::file_size(path, ec)),
+            static_cast<uint64_t>(fs::last_write_time(path, ec).time_since_epoch().count()),
+        };
+        if (ec) {
+            return 0;
+        }
+        for (const auto value : values) {
+            hash = (hash ^ value) * FNV_PRIME;
+        }
+    }
+    return hash;
+}
+
+std::vector<uint8_t> Lexicon::build(const std::string &data_root) {
+    std::string contents[TABLE_COUNT];
+    std::vector<std::pair<std::string_view, std::string_view>> tables[TABLE_COUNT];
+
+    for (auto t = 0U; t < TABLE_COUNT; ++t) {
+        const auto path = data_root + "/" + SOURCE_FILE_NAME_LIST[t];
+        const auto start = lisa::utils::current_ts_us();
+        if (!read_file(path, contents[t])) {
+            spdlog::error("Read lexicon source failed! target path: {}", path);
+            return {};
+        }
+
+        const std::string_view content = contents[t];
+        const auto &source = TABLE_SOURCE_LIST[t];
+        auto &table = tables[t];
+        for (size_t pos = 0; pos < content.size();) {
+            const auto end = std::min(content.find('\n', pos), content.size());
+            const auto line = content.substr(pos, end - pos);
+            pos = end + 1;
+            if (!source.keyed) {
+                table.emplace_back(std::string_view{}, line);
+                continue;
+            }
+            const auto sep = line.find(' ');
+            if (sep == std::string_view::npos || sep + source.value_skip > line.size()) {
+                continue;
+            }
+            table.emplace_back(line.substr(0, sep), line.substr(sep + source.value_skip));
+        }
+
+        if (source.keyed) {
+            // Later lines override earlier ones, as they did with the hash maps.
+            std::stable_sort(table.begin(), table.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            auto last = table.begin();
+            for (auto iter = table.begin(); iter != table.end(); ++iter) {
+                if (std::next(iter) != table.end() && std::next(iter)->first == iter->first) {
+                    continue;
+                }
+                *last++ = *iter;
+            }
+            table.erase(last, table.end());
+        }
+        spdlog::debug("Reading lexicon source [{}] done, entries: {}, time cost: {} us", path, table.size(),
+                      lisa::utils::current_ts_us() - start);
+    }
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.fingerprint = fingerprint(data_root);
+    header.content_hash = FNV_OFFSET_BASIS;
+    for (const auto &content : contents) {
+        for (const auto ch : content) {
+            header.content_hash = (header.content_hash ^ static_cast<uint8_t>(ch)) * FNV_PRIME;
+        }
+        header.content_hash = (header.content_hash ^ content.size()) * FNV_PRIME;
+    }
+    uint64_t offset = sizeof(Header);
+    for (auto t = 0U; t < TABLE_COUNT; ++t) {
+        header.tables[t].offset = offset;
+        header.tables[t].count = tables[t].size();
+        offset += tables[t].size() * sizeof(Entry);
+    }
+    for (auto t = 0U; t < TABLE_COUNT; ++t) {
+        // Power of two and at most half full, so every probe sequence ends at an empty slot.
+        uint64_t slot_count = 0;
+        if (TABLE_SOURCE_LIST[t].keyed) {
+            slot_count = 2;
+            while (slot_count < tables[t].size() * 2) {
+                slot_count *= 2;
+            }
+        }
+        header.tables[t].slot_offset = offset;
+        header.tables[t].slot_count = slot_count;
+        offset += slot_count * sizeof(uint32_t);
+    }
+
+    std::string pool;
+    std::vector<uint32_t> items;
+    std::vector<LexiconPhone> phones;
+    std::vector<uint32_t> symbols;
+    std::unordered_map<std::string, uint32_t> symbol_index;
+    const auto add_phone = [&](std::string name, uint32_t tone) {
+        auto iter = symbol_index.find(name);
+        if (iter == symbol_index.end()) {
+            symbols.push_back(static_cast<uint32_t>(pool.size()));
+            symbols.push_back(static_cast<uint32_t>(name.size()));
+            pool.append(name);
+            iter = symbol_index.emplace(std::move(name), static_cast<uint32_t>(symbol_index.size())).first;
+        }
+        phones.push_back(LexiconPhone{iter->second, tone});
+    };
+
+    std::vector<Entry> entries;
+    for (auto t = 0U; t < TABLE_COUNT; ++t) {
+        const auto delim = TABLE_SOURCE_LIST[t].item_delim;
+        const auto phone_style = TABLE_SOURCE_LIST[t].phone_style;
+        for (const auto &[key, value] : tables[t]) {
+            Entry entry{};
+            entry.key_offset = static_cast<uint32_t>(pool.size());
+            entry.key_size = static_cast<uint32_t>(key.size());
+            pool.append(key);
+            entry.value_offset = static_cast<uint32_t>(pool.size());
+            entry.value_size = static_cast<uint32_t>(value.size());
+            pool.append(value);
+
+            entry.item_index = static_cast<uint32_t>(items.size() / ITEM_FIELDS);
+            for (size_t pos = 0; pos < value.size();) {
+                const auto end = delim.empty() ? value.size() : std::min(value.find(delim, pos), value.size());
+                const auto item = value.substr(pos, end - pos);
+                pos = end + delim.size();
+                if (item.empty()) {
+                    continue;
+                }
+                const auto phone_index = phones.size();
+                if (phone_style == PhoneStyle::CHINESE) {
+                    add_phone(std::string(item), 0);
+                } else if (phone_style == PhoneStyle::ENGLISH) {
+                    for (size_t phone_pos = 0; phone_pos < item.size();) {
+                        const auto phone_end = std::min(item.find(' ', phone_pos), item.size());
+                        auto phone = item.substr(phone_pos, phone_end - phone_pos);
+                        phone_pos = phone_end + 1;
+                        if (phone.empty()) {
+                            continue;
+                        }
+                        uint32_t tone = 0;
+                        if (isdigit(phone.back())) {
+                            tone = phone.back() - '0' + 1;
+                            phone.remove_suffix(1);
+                        }
+                        std::string name(phone);
+                        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                        add_phone(std::move(name), tone);
+                    }
+                }
+                items.push_back(static_cast<uint32_t>(entry.value_offset + (item.data() - value.data())));
+                items.push_back(static_cast<uint32_t>(item.size()));
+                items.push_back(static_cast<uint32_t>(phone_index));
+                items.push_back(static_cast<uint32_t>(phones.size() - phone_index));
+            }
+            entry.item_count = static_cast<uint32_t>(items.size() / ITEM_FIELDS - entry.item_index);
+            entries.push_back(entry);
+        }
+    }
+    header.item_offset = offset;
+    header.item_count = items.size() / ITEM_FIELDS;
+    offset += items.size() * sizeof(uint32_t);
+    header.phone_offset = offset;
+    header.phone_count = phones.size();
+    offset += phones.size() * sizeof(LexiconPhone);
+    header.symbol_offset = offset;
+    header.symbol_count = symbols.size() / 2;
+    offset += symbols.size() * sizeof(uint32_t);
+    header.pool_offset = offset;
+    header.pool_size = pool.size();
+
+    std::vector<uint8_t> image(offset + pool.size(), 0);
+    std::memcpy(image.data(), &header, sizeof(header));
+    std::memcpy(image.data() + sizeof(Header), entries.data(), entries.size() * sizeof(Entry));
+    std::memcpy(image.data() + header.item_offset, items.data(), items.size() * sizeof(uint32_t));
+    std::memcpy(image.data() + header.phone_offset, phones.data(), phones.size() * sizeof(LexiconPhone));
+    std::memcpy(image.data() + header.symbol_offset, symbols.data(), symbols.size() * sizeof(uint32_t));
+    std::memcpy(image.data() + header.pool_offset, pool.data(), pool.size());
+
+    for (auto t = 0U; t < TABLE_COUNT; ++t) {
+        const auto &table_header = header.tables[t];
+        if (table_header.slot_count == 0) {
+            continue;
+        }
+        const auto slots = reinterpret_cast<uint32_t *>(image.data() + table_header.slot_offset);
+        const auto mask = table_header.slot_count - 1;
+        for (auto i = 0U; i < tables[t].size(); ++i) {
+            auto slot = hash_key(FNV_OFFSET_BASIS, tables[t][i].first) & mask;
+            while (slots[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = i + 1;
+        }
+    }
+    return image;
+}
+
+bool Lexicon::validate() const {
+    if (size_ < sizeof(Header) || header().magic != MAGIC || header().version != VERSION) {
+        return false;
+    }
+    const auto &hdr = header();
+    // Sections follow each other in this order, each aligned for its own records.
+    if (hdr.pool_offset > size_ || hdr.pool_size > size_ - hdr.pool_offset || hdr.item_offset % alignof(uint32_t) != 0 ||
+        hdr.item_offset > hdr.phone_offset ||
+        hdr.item_count > (hdr.phone_offset - hdr.item_offset) / (ITEM_FIELDS * sizeof(uint32_t)) ||
+        hdr.phone_offset % alignof(LexiconPhone) != 0 || hdr.phone_offset > hdr.symbol_offset ||
+        hdr.phone_count > (hdr.symbol_offset - hdr.phone_offset) / sizeof(LexiconPhone) ||
+        hdr.symbol_offset % alignof(uint32_t) != 0 || hdr.symbol_offset > hdr.pool_offset ||
+        hdr.symbol_count > (hdr.pool_offset - hdr.symbol_offset) / (2 * sizeof(uint32_t))) {
+        return false;
+    }
+    const auto items = reinterpret_cast<const uint32_t *>(data_ + hdr.item_offset);
+    for (auto i = 0U; i < hdr.item_count; ++i) {
+        const auto item = items + i * ITEM_FIELDS;
+        if (uint64_t{item[0]} + item[1] > hdr.pool_size || uint64_t{item[2]} + item[3] > hdr.phone_count) {
+            return false;
+        }
+    }
+    const auto phones = reinterpret_cast<const LexiconPhone *>(data_ + hdr.phone_offset);
+    for (auto i = 0U; i < hdr.phone_count; ++i) {
+        if (phones[i].symbol >= hdr.symbol_count) {
+            return false;
+        }
+    }
+    const auto symbols = reinterpret_cast<const uint32_t *>(data_ + hdr.symbol_offset);
+    for (auto i = 0U; i < hdr.symbol_count; ++i) {
+        if (uint64_t{symbols[i * 2]} + symbols[i * 2 + 1] > hdr.pool_size) {
+            return false;
+        }
+    }
+    for (auto t = 0U; t < TABLE_COUNT; ++t) {
+        const auto &table = hdr.tables[t];
+        if (table.offset < sizeof(Header) || table.offset % alignof(Entry) != 0 ||
+            table.offset > hdr.item_offset || table.count > (hdr.item_offset - table.offset) / sizeof(Entry)) {
+            return false;
+        }
+        if (table.slot_count != 0 &&
+            ((table.slot_count & (table.slot_count - 1)) != 0 || table.slot_count <= table.count ||
+             table.slot_offset % alignof(uint32_t) != 0 || table.slot_offset > hdr.item_offset ||
+             table.slot_count > (hdr.item_offset - table.slot_offset) / sizeof(uint32_t))) {
+            return false;
+        }
+        const auto slots = reinterpret_cast<const uint32_t *>(data_ + table.slot_offset);
+        for (auto i = 0U; i < table.slot_count; ++i) {
+            if (slots[i] > table.count) {
+                return false;
+            }
+        }
+        const auto begin = reinterpret_cast<const Entry *>(data_ + table.offset);
+        for (auto entry = begin; entry != begin + table.count; ++entry) {
+            if (uint64_t{entry->key_offset} + entry->key_size > hdr.pool_size ||
+                uint64_t{entry->value_offset} + entry->value_size > hdr.pool_size ||
+                uint64_t{entry->item_index} + entry->item_count > hdr.item_count) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+const Lexicon::Entry *Lexicon::entries(LexiconTable table) const {
+    return reinterpret_cast<const Entry *>(data_ + header().tables[static_cast<size_t>(table)].offset);
+}
+
+std::string_view Lexicon::pool(uint32_t offset, uint32_t size) const {
+    return std::string_view(reinterpret_cast<const char *>(data_ + header().pool_offset) + offset, size);
+}
+
+LexiconValue Lexicon::items(const Entry &entry) const {
+    const auto items = reinterpret_cast<const uint32_t *>(data_ + header().item_offset);
+    return LexiconValue(reinterpret_cast<const char *>(data_ + header().pool_offset),
+                        items + entry.item_index * ITEM_FIELDS, entry.item_count,
+                        reinterpret_cast<const LexiconPhone *>(data_ + header().phone_offset));
+}
+
+} // namespace lisa::language
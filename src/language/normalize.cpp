@@ -2,6 +2,9 @@
 
 #include "language/normalize.h"
 
+#include <cwctype>
+#include <stdexcept>
+
 #include "language/number.h"
 #include "spdlog/spdlog.h"
 #include "utils/string.h"
@@ -9,117 +12,167 @@
 
 namespace lisa {
 
-const std::unordered_set<wchar_t> SentenceNormalizer::supported_punctuations_ = {
-    L',', L'.', L'!', L'?', L':', L';',
-};
+namespace {
 
-const std::unordered_map<wchar_t, wchar_t> SentenceNormalizer::punctuation_mapper_ = {
-    {L'，', L','}, {L'。', L'.'}, {L'！', L'!'}, {L'？', L'?'}, {L'：', L':'},
-    {L'；', L';'}, {L'、', L','}, {L'…', L'.'},  {L'-', L' '},  {L'—', L' '},
+constexpr lisa::utils::CodePointEntry<char> PUNCTUATION_MAPPING_LIST[] = {
+    {U'，', ','}, {U'。', '.'}, {U'！', '!'}, {U'？', '?'}, {U'：', ':'},
+    {U'；', ';'}, {U'、', ','}, {U'…', '.'},  {U'-', ' '},  {U'—', ' '},
 };
 
-std::unordered_set<char> SentenceNormalizer::get_supported_punctuations() {
-    return std::unordered_set<char>(supported_punctuations_.begin(), supported_punctuations_.end());
-}
+constexpr lisa::utils::CodePointMap<char, lisa::utils::code_point_pages(PUNCTUATION_MAPPING_LIST)> punctuation_mapper{
+    PUNCTUATION_MAPPING_LIST};
+
+} // namespace
+
+// The passes the normalizer used to chain, each over the output of the previous
+// one, fused into a pipeline fed one character at a time after number expansion:
+//   remap punctuation -> drop unrecognized characters -> collapse runs of spaces
+//   and punctuation into their first punctuation (or one space) -> strip them at
+//   both ends and end with '.' -> turn a space between two chinese characters into
+//   ',' -> add a space after inner punctuation -> split lower from upper case.
+// Collapsing makes every run a single character whose neighbours are known once
+// the next kept character arrives, so one character of state is enough.
+class SentenceNormalizer::Stream {
+public:
+    explicit Stream(std::string &result) : result_(result) {}
+
+    void push(wchar_t ch) {
+        if (const auto mapped = punctuation_mapper[ch]) {
+            ch = mapped;
+        }
+        if (is_separator(ch)) {
+            if (!pending_) {
+                pending_ = ch;
+            } else if (pending_ == L' ' && ch != L' ') {
+                pending_ = ch;
+            }
+            return;
+        }
+        if (!is_chinese(ch) && !iswalpha(ch)) {
+            return;
+        }
+        if (pending_) {
+            // A leading run is stripped.
+            if (last_) {
+                const auto separator = pending_ == L' ' && is_chinese(last_) && is_chinese(ch) ? L',' : pending_;
+                emit(separator);
+                if (separator != L' ') {
+                    emit(L' ');
+                }
+            }
+            pending_ = 0;
+        }
+        emit(ch);
+    }
+
+    // A trailing run is stripped, a non empty sentence always ends with '.'.
+    void finish() {
+        if (last_) {
+            emit(L'.');
+        }
+    }
+
+private:
+    void emit(wchar_t ch) {
+        if (iswlower(last_) && iswupper(ch)) {
+            result_.push_back(' ');
+        }
+        lisa::utils::utf8_append(result_, ch);
+        last_ = ch;
+    }
+
+    std::string &result_;
+    wchar_t pending_{};
+    wchar_t last_{};
+};
 
 std::string SentenceNormalizer::normalize(const std::string &sentence) {
     const auto start = lisa::utils::current_ts_us();
-    std::wstring wsentence = utils::utf8_to_wstring(sentence);
-    wsentence = replace_number(wsentence);
-    wsentence = remap_punctuation(wsentence);
-    wsentence = remove_unrecognized_chars(wsentence);
-    wsentence = remove_continuous_punctuation(wsentence);
-    wsentence = strip_punctuation_begin_and_end(wsentence);
-    wsentence = replace_space_between_chinese_and_chinese(wsentence);
-    wsentence = append_space_after_inner_punctuation(wsentence);
-    wsentence = append_space_between_english_lower_and_upper(wsentence);
-    const auto result = utils::wstring_to_utf8(wsentence);
+    std::string result;
+    normalize(sentence, result);
     spdlog::debug("Normalize sentence done, time cost: {} us", lisa::utils::current_ts_us() - start);
     spdlog::debug("Original sentence is: [{}]", sentence);
     spdlog::debug("Normalized sentence is: [{}]", result);
     return result;
 }
 
-std::wstring SentenceNormalizer::replace_number(const std::wstring &sentence) {
-    return NumberHelper::number_to_chinese(sentence);
-}
-
-std::wstring SentenceNormalizer::remap_punctuation(const std::wstring &sentence) {
-    std::wstring result;
-    for (const auto &ch : sentence) {
-        const auto iter = punctuation_mapper_.find(ch);
-        result.push_back(iter == punctuation_mapper_.end() ? ch : iter->second);
-    }
-    return result;
-}
-
-std::wstring SentenceNormalizer::remove_unrecognized_chars(const std::wstring &sentence) {
-    std::wstring result;
-    for (const auto &ch : sentence) {
-        if (!is_chinese(ch) && !iswalpha(ch) && ch != L' ' && !is_supported_punctuation(ch)) {
-            continue;
+void SentenceNormalizer::normalize(std::string_view sentence, std::string &result) {
+    result.clear();
+    result.reserve(sentence.size() + sentence.size() / 2);
+    Stream stream(result);
+
+    // Numbers are cut out as NumberHelper::number_to_chinese splits them: an
+    // optional '-' or a '.' right before a digit, digits and inner '.', and an
+    // optional closing '%'. Whether a number is a year depends on the character
+    // right after it, so a number is only expanded once that one is seen.
+    std::wstring number;
+    std::wstring chinese;
+    bool number_closed = false;
+    const auto flush_number = [&](wchar_t next) {
+        if (!number.empty()) {
+            chinese.clear();
+            NumberHelper::number_token_to_chinese(number, next == L'年', chinese);
+            for (const auto ch : chinese) {
+                stream.push(ch);
+            }
+            number.clear();
         }
-        result.push_back(ch);
-    }
-    return result;
-}
-
-std::wstring SentenceNormalizer::remove_continuous_punctuation(const std::wstring &sentence) {
-    std::wstring result;
-    for (auto i = 0U; i < sentence.size(); ++i) {
-        result.push_back(sentence[i]);
-        if (sentence[i] == L' ' || is_supported_punctuation(sentence[i])) {
-            while (i + 1 < sentence.size() && (sentence[i + 1] == L' ' || is_supported_punctuation(sentence[i + 1]))) {
-                if (result.back() == L' ' && sentence[i + 1] != L' ') {
-                    result.back() = sentence[i + 1];
-                }
-                ++i;
+        number_closed = false;
+    };
+    const auto is_digit = [](char32_t ch) { return ch >= L'0' && ch <= L'9'; };
+
+    char32_t ch = 0;
+    size_t pos = 0;
+    size_t length = 0;
+    const auto decode = [&](size_t at, char32_t &out) {
+        if (at >= sentence.size()) {
+            return size_t{0};
+        }
+        const auto size = lisa::utils::utf8_sequence(sentence, at, out);
+        if (size == 0) {
+            // As utf8_to_wstring: a truncated tail ends the text, anything else is an error.
+            if (lisa::utils::utf8_truncated_tail(sentence.substr(at))) {
+                return size_t{0};
             }
+            throw std::range_error("normalize: malformed UTF-8");
         }
-    }
-    return result;
-}
+        return size;
+    };
 
-std::wstring SentenceNormalizer::strip_punctuation_begin_and_end(const std::wstring &sentence) {
-    std::wstring symbols(supported_punctuations_.begin(), supported_punctuations_.end());
-    symbols.push_back(L' ');
-    auto result = lisa::utils::string_strip(sentence, symbols);
-    if (!result.empty() && result.back() != L'.') {
-        result.push_back(L'.');
-    }
-    return result;
-}
+    length = decode(pos, ch);
+    while (length != 0) {
+        char32_t next = 0;
+        const auto next_length = decode(pos + length, next);
+        const auto next_is_digit = next_length != 0 && is_digit(next);
 
-std::wstring SentenceNormalizer::replace_space_between_chinese_and_chinese(const std::wstring &sentence) {
-    std::wstring result = sentence;
-    for (auto i = 1U; i + 1 < result.size(); ++i) {
-        if (result[i] == L' ' && is_chinese(result[i - 1]) && is_chinese(result[i + 1])) {
-            result[i] = L',';
+        if (number_closed) {
+            flush_number(static_cast<wchar_t>(ch));
         }
-    }
-    return result;
-}
-
-std::wstring SentenceNormalizer::append_space_after_inner_punctuation(const std::wstring &sentence) {
-    std::wstring result;
-    for (auto i = 0U; i < sentence.size(); ++i) {
-        result.push_back(sentence[i]);
-        if (is_supported_punctuation(sentence[i]) && i + 1 < sentence.size() && sentence[i + 1] != L' ') {
-            result.push_back(L' ');
+        if (is_digit(ch)) {
+            number.push_back(static_cast<wchar_t>(ch));
+        } else if (ch == L'-' || (ch == L'.' && number.empty())) {
+            flush_number(static_cast<wchar_t>(ch));
+            if (next_is_digit) {
+                number.push_back(static_cast<wchar_t>(ch));
+            } else {
+                stream.push(static_cast<wchar_t>(ch));
+            }
+        } else if (ch == L'.' && next_is_digit) {
+            number.push_back(L'.');
+        } else if (ch == L'%' && !number.empty()) {
+            number.push_back(L'%');
+            number_closed = true;
+        } else {
+            flush_number(static_cast<wchar_t>(ch));
+            stream.push(static_cast<wchar_t>(ch));
         }
-    }
-    return result;
-}
 
-std::wstring SentenceNormalizer::append_space_between_english_lower_and_upper(const std::wstring &sentence) {
-    std::wstring result;
-    for (auto i = 0U; i < sentence.size(); ++i) {
-        result.push_back(sentence[i]);
-        if (iswlower(sentence[i]) && i + 1 < sentence.size() && iswupper(sentence[i + 1])) {
-            result.push_back(L' ');
-        }
+        pos += length;
+        ch = next;
+        length = next_length;
     }
-    return result;
+    flush_number(0);
+    stream.finish();
 }
 
 } // namespace doge
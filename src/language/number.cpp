@@ -3,217 +3,179 @@
 #include "language/number.h"
 
 #include <algorithm>
-#include <array>
 #include <cassert>
-#include <cwctype>
-
-#include "utils/string.h"
+#include <stdexcept>
 
 namespace lisa {
 
-const std::unordered_map<wchar_t, wchar_t> NumberHelper::number_chinese_mapper_ = {
-    {L'0', L'零'}, {L'1', L'一'}, {L'2', L'二'}, {L'3', L'三'}, {L'4', L'四'},
-    {L'5', L'五'}, {L'6', L'六'}, {L'7', L'七'}, {L'8', L'八'}, {L'9', L'九'},
-};
+static bool is_digit(wchar_t ch) { return ch >= L'0' && ch <= L'9'; }
 
 std::wstring NumberHelper::number_to_chinese(const std::wstring &sentence) {
-    auto number_and_other = split_number_and_other(sentence);
-    for (auto i = 0U; i < number_and_other.size(); ++i) {
-        auto &[is_number, number] = number_and_other[i];
-        if (is_number) {
-            assert(!number.empty());
-            std::wstring chinese;
-            if (number.front() == L'-') {
-                chinese.push_back(L'负');
-                number = number.substr(1);
-            }
-            if (number.back() == L'%') {
-                chinese += L"百分之";
-                number.pop_back();
-            }
-            assert(!number.empty());
-            const auto pos = number.find_first_of(L'.');
-            if (pos == std::wstring::npos) {
-                if (i + 1 < number_and_other.size() && !number_and_other[i + 1].first &&
-                    !number_and_other[i + 1].second.empty() && number_and_other[i + 1].second.front() == L'年') {
-                    chinese += number_to_chinese_directly(number);
-                } else {
-                    chinese += number_to_chinese_complex(number);
-                }
-            } else {
-                auto integer = number.substr(0, pos);
-                if (integer.empty()) {
-                    chinese.push_back(L'零');
-                } else {
-                    chinese += number_to_chinese_complex(integer);
-                }
-                auto decimal = number.substr(pos + 1);
-                if (!decimal.empty()) {
-                    chinese.push_back(L'点');
-                    chinese += number_to_chinese_directly(number.substr(pos + 1));
-                }
-            }
-            if (chinese == L"负零") {
-                chinese = L"零";
-            } else if (chinese.size() >= 2 && chinese[0] == L'二' && chinese[1] == L'千') {
-                chinese[0] = L'两';
-            }
-            number = std::move(chinese);
-        }
-    }
+    const std::wstring_view text = sentence;
     std::wstring result;
-    for (const auto &[is_number, part] : number_and_other) {
-        result += part;
+    result.reserve(text.size() * 2);
+    for (size_t pos = 0; pos < text.size();) {
+        const auto end = number_token_end(text, pos);
+        if (end == pos) {
+            result.push_back(text[pos++]);
+            continue;
+        }
+        number_token_to_chinese(text.substr(pos, end - pos), end < text.size() && text[end] == L'年', result);
+        pos = end;
     }
     return result;
 }
 
-std::wstring NumberHelper::number_to_chinese_directly(const std::wstring &sentence) {
-    std::wstring result;
-    for (const auto &ch : sentence) {
-        if (ch == '.') {
+// A number starts at a digit, or at a '-' or '.' right before one, runs over
+// digits and the '.' followed by a digit, and ends after an optional '%'.
+size_t NumberHelper::number_token_end(std::wstring_view sentence, size_t begin) {
+    const auto digit_at = [&](size_t pos) { return pos < sentence.size() && is_digit(sentence[pos]); };
+    const auto first = sentence[begin];
+    if (!is_digit(first) && !((first == L'-' || first == L'.') && digit_at(begin + 1))) {
+        return begin;
+    }
+    auto pos = begin + 1;
+    while (pos < sentence.size()) {
+        if (is_digit(sentence[pos]) || (sentence[pos] == L'.' && digit_at(pos + 1))) {
+            ++pos;
+            continue;
+        }
+        if (sentence[pos] == L'%') {
+            ++pos;
+        }
+        break;
+    }
+    return pos;
+}
+
+void NumberHelper::number_token_to_chinese(std::wstring_view number, bool before_year, std::wstring &result) {
+    assert(!number.empty());
+    const auto start = result.size();
+    if (number.front() == L'-') {
+        result.push_back(L'负');
+        number.remove_prefix(1);
+    }
+    if (number.back() == L'%') {
+        result.append(L"百分之");
+        number.remove_suffix(1);
+    }
+    assert(!number.empty());
+    const auto pos = number.find(L'.');
+    if (pos == std::wstring_view::npos) {
+        if (before_year) {
+            number_to_chinese_directly(number, result);
+        } else {
+            number_to_chinese_complex(number, result);
+        }
+    } else {
+        if (pos == 0) {
+            result.push_back(L'零');
+        } else {
+            number_to_chinese_complex(number.substr(0, pos), result);
+        }
+        if (pos + 1 < number.size()) {
+            result.push_back(L'点');
+            number_to_chinese_directly(number.substr(pos + 1), result);
+        }
+    }
+    const auto chinese = std::wstring_view(result).substr(start);
+    if (chinese == L"负零") {
+        result.erase(start, 1);
+    } else if (chinese.size() >= 2 && chinese[0] == L'二' && chinese[1] == L'千') {
+        result[start] = L'两';
+    }
+}
+
+void NumberHelper::number_to_chinese_directly(std::wstring_view digits, std::wstring &result) {
+    for (const auto ch : digits) {
+        if (ch == L'.') {
             result.push_back(L'点');
             continue;
         }
-        const auto iter = number_chinese_mapper_.find(ch);
-        assert(iter != number_chinese_mapper_.end());
-        result.push_back(iter->second);
+        assert(is_digit(ch));
+        result.push_back(CHINESE_DIGITS[ch - L'0']);
     }
-    return result;
 }
 
-std::wstring NumberHelper::number_to_chinese_complex(uint64_t number) {
+// Zeros between digits read as one '零', leading and trailing ones not at all,
+// and "一十" as "十".
+wchar_t *NumberHelper::number_to_chinese_complex(uint64_t number, wchar_t *end) {
     assert(number < 10000);
-    std::wstring result;
-    static const std::array<std::wstring, 4> units = {L"", L"十", L"百", L"千"};
-    for (auto i = 0U; i < 4; ++i) {
+    std::array<wchar_t, GROUP_MAX_LENGTH> buffer;
+    auto *last = buffer.data() + buffer.size();
+    auto *first = last;
+    for (auto i = 0U; i < DIGIT_UNITS.size(); ++i) {
         const auto digit = number % 10;
         if (digit == 0) {
-            if (result.empty() || result[0] != L'零') {
-                result = L'零' + result;
+            if (first == last || *first != L'零') {
+                *--first = L'零';
             }
         } else {
-            result = number_chinese_mapper_.at(digit + L'0') + units[i] + result;
+            if (DIGIT_UNITS[i] != L'\0') {
+                *--first = DIGIT_UNITS[i];
+            }
+            *--first = CHINESE_DIGITS[digit];
         }
         number /= 10;
     }
-    result = lisa::utils::string_strip(result, L"零");
-    if (result.size() >= 2 && result[0] == L'一' && result[1] == L'十') {
-        result = result.substr(1);
+    while (first != last && *first == L'零') {
+        ++first;
     }
-    return result;
+    while (last != first && last[-1] == L'零') {
+        --last;
+    }
+    if (last - first >= 2 && first[0] == L'一' && first[1] == L'十') {
+        ++first;
+    }
+    return std::copy_backward(first, last, end);
 }
 
-std::wstring NumberHelper::number_to_chinese_complex(const std::wstring &sentence) {
-    assert(!sentence.empty() && std::all_of(sentence.begin(), sentence.end(), iswdigit));
-    static const std::array<std::wstring, 4> units = {L"", L"万", L"亿", L"兆"};
-
-    uint64_t number = std::stoull(lisa::utils::wstring_to_utf8(sentence));
+// Groups of four digits read right to left, each with its unit. A zero group
+// or a short group below a non zero one reads as a '零' before it.
+void NumberHelper::number_to_chinese_complex(std::wstring_view digits, std::wstring &result) {
+    assert(!digits.empty());
+    uint64_t number = 0;
+    for (const auto ch : digits) {
+        assert(is_digit(ch));
+        const uint64_t digit = ch - L'0';
+        if (number > (UINT64_MAX - digit) / 10) {
+            throw std::out_of_range("number_to_chinese: integer out of range");
+        }
+        number = number * 10 + digit;
+    }
     assert(number < 10000000000000000ULL);
 
-    std::wstring result;
-    for (auto i = 0U; i < 4; ++i) {
+    std::array<wchar_t, INTEGER_MAX_LENGTH> buffer;
+    auto *last = buffer.data() + buffer.size();
+    auto *first = last;
+    for (auto i = 0U; i < GROUP_COUNT; ++i) {
         const auto part = number % 10000;
         if (part == 0) {
-            if (result.empty() || result[0] != L'零') {
-                result = L'零' + result;
+            if (first == last || *first != L'零') {
+                *--first = L'零';
             }
         } else {
-            result = number_to_chinese_complex(part) + units[i] + result;
+            if (GROUP_UNITS[i] != L'\0') {
+                *--first = GROUP_UNITS[i];
+            }
+            first = number_to_chinese_complex(part, first);
             if (part < 1000 && number >= 10000) {
-                result = L'零' + result;
+                *--first = L'零';
             }
         }
         number /= 10000;
     }
-    result = lisa::utils::string_strip(result, L"零");
-    return result.empty() ? L"零" : result;
-}
-
-std::vector<std::pair<bool, std::wstring>> NumberHelper::split_number_and_other(const std::wstring &sentence) {
-    std::vector<std::pair<bool, std::wstring>> result;
-    std::wstring current;
-    bool is_number = false;
-    for (auto i = 0U; i < sentence.size(); ++i) {
-        const auto &ch = sentence[i];
-        if (ch == L'-') {
-            if (i + 1 < sentence.size() && iswdigit(sentence[i + 1])) {
-                if (!current.empty()) {
-                    result.emplace_back(is_number, std::move(current));
-                    current.clear();
-                }
-                current.push_back(ch);
-                is_number = true;
-            } else {
-                if (is_number) {
-                    result.emplace_back(is_number, std::move(current));
-                    current.clear();
-                }
-                current.push_back(ch);
-                is_number = false;
-            }
-            continue;
-        }
-        if (ch == L'.') {
-            if (is_number) {
-                if (i + 1 < sentence.size() && iswdigit(sentence[i + 1])) {
-                    current.push_back(ch);
-                } else {
-                    result.emplace_back(is_number, std::move(current));
-                    current.clear();
-                    current.push_back(ch);
-                    is_number = false;
-                }
-            } else if (i + 1 < sentence.size() && iswdigit(sentence[i + 1])) {
-                if (!current.empty()) {
-                    result.emplace_back(is_number, std::move(current));
-                    current.clear();
-                }
-                current.push_back(ch);
-                is_number = true;
-            } else {
-                if (is_number) {
-                    result.emplace_back(is_number, std::move(current));
-                    current.clear();
-                }
-                current.push_back(ch);
-                is_number = false;
-            }
-            continue;
-        }
-        if (ch == L'%') {
-            if (is_number) {
-                current.push_back(ch);
-                result.emplace_back(is_number, std::move(current));
-                current.clear();
-                is_number = false;
-            } else {
-                current.push_back(ch);
-            }
-            continue;
-        }
-        if (iswdigit(ch)) {
-            if (!is_number) {
-                if (!current.empty()) {
-                    result.emplace_back(is_number, std::move(current));
-                    current.clear();
-                }
-                is_number = true;
-            }
-            current.push_back(ch);
-            continue;
-        }
-        if (is_number) {
-            result.emplace_back(is_number, std::move(current));
-            current.clear();
-        }
-        current.push_back(ch);
-        is_number = false;
+    while (first != last && *first == L'零') {
+        ++first;
     }
-    if (!current.empty()) {
-        result.emplace_back(is_number, std::move(current));
+    while (last != first && last[-1] == L'零') {
+        --last;
+    }
+    if (first == last) {
+        result.push_back(L'零');
+    } else {
+        result.append(first, last);
     }
-    return result;
 }
 
-} // namespace doge
+} // namespace lisa
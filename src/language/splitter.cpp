@@ -0,0 +1,349 @@
+// cute-giggle@outlook.com
+
+#include "language/splitter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <iterator>
+#include <optional>
+
+#include "language/normalize.h"
+#include "utils/string.h"
+
+namespace lisa::language {
+
+static bool is_chinese(char32_t ch) { return ch >= 0x4E00 && ch <= 0x9FA5; }
+
+static size_t char_cost(char32_t ch) { return is_chinese(ch) ? 2 : ch == U' ' ? 0 : 1; }
+
+// '.' is left out, it also sits inside numbers and abbreviations, see sentence_end.
+static bool is_sentence_end(char32_t ch) {
+    switch (ch) {
+    case U'\n':
+    case U'!':
+    case U'?':
+    case U';':
+    case U'。':
+    case U'！':
+    case U'？':
+    case U'；':
+    case U'…':
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Closing quotes and brackets right after a sentence end stay with it.
+static bool is_closer(char32_t ch) {
+    switch (ch) {
+    case U'"':
+    case U'\'':
+    case U')':
+    case U'”':
+    case U'’':
+    case U'）':
+    case U'」':
+    case U'』':
+    case U'】':
+    case U'》':
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Titles whose '.' rarely ends a sentence, compared ignoring case.
+constexpr std::string_view ABBREVIATIONS[] = {"mr", "mrs", "ms", "dr", "prof", "sr", "jr", "vs"};
+
+static bool is_letter(char ch) { return isalpha(static_cast<uint8_t>(ch)) != 0; }
+
+static bool is_upper(char ch) { return isupper(static_cast<uint8_t>(ch)) != 0; }
+
+// Start of the letters text ends with.
+static size_t word_begin(std::string_view text) {
+    auto begin = text.size();
+    while (begin > 0 && is_letter(text[begin - 1])) {
+        --begin;
+    }
+    return begin;
+}
+
+// Whether a '.' between before and after closes an abbreviation: one of the
+// titles, a letter of "e.g." or "U.S.", or a capital initial next to another
+// one or between capitalised words, as in "J. R. R. Tolkien" or "John F.
+// Kennedy". Other single letters, as in "plan B.", end the sentence. nullopt
+// while the text after the '.' needed to tell has not arrived.
+static std::optional<bool> ends_abbreviation(std::string_view before, std::string_view after, bool finished) {
+    const auto begin = word_begin(before);
+    const auto word = before.substr(begin);
+    if (word.size() != 1) {
+        return std::any_of(std::begin(ABBREVIATIONS), std::end(ABBREVIATIONS), [&](std::string_view abbreviation) {
+            return std::equal(word.begin(), word.end(), abbreviation.begin(), abbreviation.end(),
+                              [](char a, char b) { return tolower(static_cast<uint8_t>(a)) == b; });
+        });
+    }
+    if (begin > 0 && before[begin - 1] == '.') {
+        return true;
+    }
+    if (!is_upper(word[0])) {
+        return false;
+    }
+    // The word before, an initial itself when it is a capital followed by '.'.
+    auto previous = before.substr(0, begin);
+    while (!previous.empty() && previous.back() == ' ') {
+        previous.remove_suffix(1);
+    }
+    const auto initial_before = !previous.empty() && previous.back() == '.';
+    if (initial_before) {
+        previous.remove_suffix(1);
+    }
+    const auto previous_begin = word_begin(previous);
+    const auto previous_word = previous.substr(previous_begin);
+    if (initial_before && previous_word.size() == 1 && is_upper(previous_word[0])) {
+        return true;
+    }
+    const auto capitalised_before = !initial_before && !previous_word.empty() && is_upper(previous_word[0]);
+
+    const auto next = after.find_first_not_of(' ');
+    if (next == std::string_view::npos) {
+        return finished ? std::optional<bool>(false) : std::nullopt;
+    }
+    if (!is_upper(after[next])) {
+        return false;
+    }
+    if (capitalised_before) {
+        return true;
+    }
+    if (next + 1 == after.size()) {
+        return finished ? std::optional<bool>(false) : std::nullopt;
+    }
+    return after[next + 1] == '.';
+}
+
+StreamSplitter::StreamSplitter(const Config &config) : config_(config) {
+    assert(config_.target_cost > 0 && config_.target_cost <= config_.max_cost);
+    assert(config_.max_pending > 0);
+}
+
+void StreamSplitter::push(std::string_view text) {
+    assert(!finished_);
+    raw_.append(text);
+}
+
+void StreamSplitter::finish() { finished_ = true; }
+
+bool StreamSplitter::next(std::string &chunk) {
+    while (ready_.empty() && advance()) {
+    }
+    if (ready_.empty()) {
+        return false;
+    }
+    chunk = std::move(ready_.front());
+    ready_.pop_front();
+    return true;
+}
+
+void StreamSplitter::reset() {
+    raw_.clear();
+    raw_begin_ = 0;
+    scan_pos_ = 0;
+    finished_ = false;
+    chunk_.clear();
+    chunk_cost_ = 0;
+    ready_.clear();
+}
+
+size_t StreamSplitter::cost(std::string_view text) {
+    size_t result = 0;
+    for (const auto ch : lisa::utils::Utf8View(text)) {
+        result += char_cost(ch);
+    }
+    return result;
+}
+
+bool StreamSplitter::advance() {
+    if (raw_begin_ == raw_.size()) {
+        if (finished_ && !chunk_.empty()) {
+            emit();
+            return true;
+        }
+        return false;
+    }
+    auto end = sentence_end();
+    if (end == std::string::npos) {
+        if (finished_) {
+            end = raw_.size();
+        } else if (pending() > config_.max_pending) {
+            end = forced_end();
+        } else {
+            return false;
+        }
+    }
+    add_sentence(std::string_view(raw_).substr(raw_begin_, end - raw_begin_));
+    if (config_.eager) {
+        emit();
+    }
+    raw_begin_ = end;
+    scan_pos_ = std::max(scan_pos_, end);
+    // Drops the consumed text once it is most of the buffer, so a long stream is
+    // not held whole.
+    if (raw_begin_ >= COMPACT_THRESHOLD && raw_begin_ * 2 >= raw_.size()) {
+        raw_.erase(0, raw_begin_);
+        scan_pos_ -= raw_begin_;
+        raw_begin_ = 0;
+    }
+    return true;
+}
+
+// End of the first sentence in the raw text, after its run of sentence ends and
+// any closing quotes. A '.' ends one unless it closes an abbreviation or a letter
+// or digit follows right away, as in "3.14" or "example.com". A '.' or a run
+// reaching the end of the text may go on, so both wait for more text unless it
+// is finished, as does a '.' after a capital initial until the next word shows. That keeps the cuts the same however the text is pushed.
+size_t StreamSplitter::sentence_end() {
+    const std::string_view text = raw_;
+    auto pos = std::max(scan_pos_, raw_begin_);
+    auto run_begin = pos;
+    auto end = std::string::npos;
+    while (pos < text.size()) {
+        char32_t ch = 0;
+        auto length = lisa::utils::utf8_sequence(text, pos, ch);
+        if (length == 0) {
+            if (!finished_ && lisa::utils::utf8_truncated_tail(text.substr(pos))) {
+                break;
+            }
+            // Malformed, left for the normalizer to report.
+            length = 1;
+            ch = 0;
+        }
+        auto ends = is_sentence_end(ch);
+        if (ch == U'.') {
+            if (pos + 1 == text.size() && !finished_) {
+                break;
+            }
+            const auto followed = pos + 1 < text.size() && isalnum(static_cast<uint8_t>(text[pos + 1]));
+            if (!followed) {
+                const auto abbreviation =
+                    ends_abbreviation(text.substr(raw_begin_, pos - raw_begin_), text.substr(pos + 1), finished_);
+                if (!abbreviation) {
+                    break;
+                }
+                ends = !*abbreviation;
+            }
+        }
+        if (ends || (end == pos && is_closer(ch))) {
+            if (end == std::string::npos) {
+                run_begin = pos;
+            }
+            end = pos + length;
+        } else if (end != std::string::npos) {
+            return end;
+        }
+        pos += length;
+    }
+    if (finished_) {
+        return end;
+    }
+    scan_pos_ = end == std::string::npos ? pos : run_begin;
+    return std::string::npos;
+}
+
+// With no sentence end in sight: after the last space or comma, or else at the
+// last character boundary not inside a number.
+size_t StreamSplitter::forced_end() const {
+    const std::string_view window(raw_.data() + raw_begin_, config_.max_pending);
+    const auto separator = window.find_last_of(" ,\t");
+    if (separator != std::string_view::npos) {
+        return raw_begin_ + separator + 1;
+    }
+    for (auto pos = window.size(); pos > 0; --pos) {
+        const auto byte = static_cast<uint8_t>(raw_[raw_begin_ + pos]);
+        const auto in_number = isdigit(byte) && isdigit(static_cast<uint8_t>(window[pos - 1]));
+        if ((byte & 0xC0) != 0x80 && !in_number) {
+            return raw_begin_ + pos;
+        }
+    }
+    return raw_begin_ + window.size();
+}
+
+void StreamSplitter::add_sentence(std::string_view sentence) {
+    SentenceNormalizer::normalize(sentence, normalized_);
+    const std::string_view text = normalized_;
+    size_t begin = 0;
+    for (size_t pos = 0; pos < text.size(); ++pos) {
+        if (SentenceNormalizer::is_supported_punctuation(static_cast<uint8_t>(text[pos]))) {
+            add_clause(text.substr(begin, pos + 1 - begin));
+            begin = pos + 1;
+        }
+    }
+    if (begin < text.size()) {
+        add_clause(text.substr(begin));
+    }
+}
+
+// A clause above the cap is cut before the last space or chinese character that
+// keeps the piece under it. A single word above it stays whole.
+void StreamSplitter::add_clause(std::string_view clause) {
+    auto cost = StreamSplitter::cost(clause);
+    while (cost > config_.max_cost) {
+        size_t cut = 0;
+        size_t cut_cost = 0;
+        size_t total = 0;
+        const lisa::utils::Utf8View view(clause);
+        for (auto iter = view.begin(); iter != view.end() && total <= config_.max_cost; ++iter) {
+            if (total > 0 && (*iter == U' ' || is_chinese(*iter))) {
+                cut = iter.offset();
+                cut_cost = total;
+            }
+            total += char_cost(*iter);
+        }
+        if (cut == 0) {
+            break;
+        }
+        group(clause.substr(0, cut), cut_cost);
+        clause.remove_prefix(cut);
+        cost -= cut_cost;
+    }
+    group(clause, cost);
+}
+
+// Adds to the current chunk, or closes it first when the piece would carry it
+// further past the target than it is short of it now.
+void StreamSplitter::group(std::string_view piece, size_t cost) {
+    if (cost == 0) {
+        return;
+    }
+    const auto total = chunk_cost_ + cost;
+    if (chunk_cost_ > 0 && total > config_.target_cost &&
+        (total > config_.max_cost || total - config_.target_cost > config_.target_cost - chunk_cost_)) {
+        emit();
+    }
+    if (chunk_.empty()) {
+        while (!piece.empty() && piece.front() == ' ') {
+            piece.remove_prefix(1);
+        }
+    } else if (piece.front() != ' ' && SentenceNormalizer::is_supported_punctuation(static_cast<uint8_t>(chunk_.back()))) {
+        // Sentences are normalized apart, the space after their last punctuation is not there.
+        chunk_.push_back(' ');
+    }
+    chunk_.append(piece);
+    chunk_cost_ += cost;
+    if (chunk_cost_ >= config_.target_cost) {
+        emit();
+    }
+}
+
+void StreamSplitter::emit() {
+    while (!chunk_.empty() && chunk_.back() == ' ') {
+        chunk_.pop_back();
+    }
+    if (!chunk_.empty()) {
+        ready_.push_back(std::move(chunk_));
+    }
+    chunk_.clear();
+    chunk_cost_ = 0;
+}
+
+} // namespace lisa::language
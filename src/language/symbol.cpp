@@ -0,0 +1,51 @@
+// cute-giggle@outlook.com
+
+#include "language/symbol.h"
+
+#include <cassert>
+#include <mutex>
+
+namespace lisa::language {
+
+SymbolTable &SymbolTable::instance() {
+    static SymbolTable instance;
+    return instance;
+}
+
+uint32_t SymbolTable::intern(std::string_view name) {
+    if (const auto id = find(name)) {
+        return *id;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    const auto iter = ids_.find(name);
+    if (iter != ids_.end()) {
+        return iter->second;
+    }
+    const auto id = static_cast<uint32_t>(names_.size());
+    // Deque elements never move, the key views stay valid as the table grows.
+    names_.emplace_back(name);
+    ids_.emplace(names_.back(), id);
+    return id;
+}
+
+std::optional<uint32_t> SymbolTable::find(std::string_view name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const auto iter = ids_.find(name);
+    if (iter == ids_.end()) {
+        return std::nullopt;
+    }
+    return iter->second;
+}
+
+std::string_view SymbolTable::name(uint32_t id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    assert(id < names_.size());
+    return names_[id];
+}
+
+size_t SymbolTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return names_.size();
+}
+
+} // namespace lisa::language
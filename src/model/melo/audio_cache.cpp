@@ -0,0 +1,237 @@
+// cute-giggle@outlook.com
+
+#include "model/melo/audio_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+namespace lisa::model {
+
+namespace fs = std::filesystem;
+
+struct AudioCache::Segment {
+    uint32_t id{};
+    std::string path{};
+    int fd{-1};
+    uint8_t *data{};
+    uint64_t capacity{};
+    uint64_t size{};
+
+    ~Segment() {
+        if (data != nullptr) {
+            munmap(data, capacity);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+AudioCache::AudioCache(const Config &config) : config_(config) {
+    assert(!config_.root.empty());
+    config_.segment_bytes = std::max<uint64_t>(config_.segment_bytes, 1ULL << 20);
+    config_.max_bytes = std::max(config_.max_bytes, config_.segment_bytes);
+    fs::create_directories(config_.root);
+
+    const auto start = lisa::utils::current_ts_us();
+    load();
+    spdlog::info("Load audio cache [{}] done, segments: {}, entries: {}, time cost: {} us", config_.root, segments_.size(),
+                 records_.size(), lisa::utils::current_ts_us() - start);
+}
+
+AudioCache::~AudioCache() { index_.close(); }
+
+uint64_t AudioCache::make_key(const std::string &text, int64_t speaker, float speed, uint64_t lexicon) const {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const auto update = [&hash](const void *data, size_t size) {
+        for (auto i = 0U; i < size; ++i) {
+            hash ^= static_cast<const uint8_t *>(data)[i];
+            hash *= 0x100000001b3ULL;
+        }
+    };
+    const uint64_t text_size = text.size();
+    update(&text_size, sizeof(text_size));
+    update(text.data(), text.size());
+    update(&speaker, sizeof(speaker));
+    update(&speed, sizeof(speed));
+    update(&lexicon, sizeof(lexicon));
+    update(config_.model_version.data(), config_.model_version.size());
+    return hash;
+}
+
+bool AudioCache::lookup(uint64_t key, message::AudioMessage &msg) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto iter = records_.find(key);
+    if (iter == records_.end()) {
+        return false;
+    }
+    const auto &record = iter->second;
+    const auto &segment = segments_.at(record.segment_id);
+    msg.channels_ = 1;
+    msg.sample_rate_ = record.sample_rate;
+    // Aliasing the segment keeps its mapping alive even if it gets evicted meanwhile.
+    msg.view_ = std::shared_ptr<const float>(segment, reinterpret_cast<const float *>(segment->data + record.offset));
+    msg.view_size_ = record.sample_count;
+    return true;
+}
+
+bool AudioCache::insert(uint64_t key, const float *data, size_t size, uint32_t sample_rate) {
+    const auto bytes = size * sizeof(float);
+    if (bytes == 0 || bytes > config_.segment_bytes) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (records_.count(key) != 0) {
+        return true;
+    }
+    auto active = segments_.empty() ? nullptr : segments_.rbegin()->second;
+    if (!active || active->size + bytes > active->capacity) {
+        const auto id = segments_.empty() ? 0U : segments_.rbegin()->first + 1;
+        active = open_segment(id, true);
+        if (!active) {
+            return false;
+        }
+        segments_[id] = active;
+        evict();
+    }
+
+    std::memcpy(active->data + active->size, data, bytes);
+    const IndexRecord record{key, active->id, sample_rate, active->size, size};
+    active->size += bytes;
+    records_[key] = record;
+    index_.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    index_.flush();
+    return index_.good();
+}
+
+std::string AudioCache::segment_path(uint32_t id) const {
+    return config_.root + "/" + SEGMENT_FILE_PREFIX + std::to_string(id) + SEGMENT_FILE_SUFFIX;
+}
+
+std::shared_ptr<AudioCache::Segment> AudioCache::open_segment(uint32_t id, bool create) {
+    auto segment = std::make_shared<Segment>();
+    segment->id = id;
+    segment->path = segment_path(id);
+    segment->fd = open(segment->path.c_str(), O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+    if (segment->fd < 0) {
+        spdlog::error("Open audio cache segment failed! target path: {}", segment->path);
+        return nullptr;
+    }
+
+    struct stat st {};
+    if (fstat(segment->fd, &st) != 0) {
+        spdlog::error("Stat audio cache segment failed! target path: {}", segment->path);
+        return nullptr;
+    }
+    segment->capacity = create ? config_.segment_bytes : static_cast<uint64_t>(st.st_size);
+    if (segment->capacity == 0 || (create && ftruncate(segment->fd, segment->capacity) != 0)) {
+        spdlog::error("Resize audio cache segment failed! target path: {}", segment->path);
+        return nullptr;
+    }
+
+    auto data = mmap(nullptr, segment->capacity, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (data == MAP_FAILED) {
+        spdlog::error("Map audio cache segment failed! target path: {}", segment->path);
+        return nullptr;
+    }
+    segment->data = static_cast<uint8_t *>(data);
+    return segment;
+}
+
+void AudioCache::load() {
+    const std::string prefix = SEGMENT_FILE_PREFIX;
+    const std::string suffix = SEGMENT_FILE_SUFFIX;
+    for (const auto &entry : fs::directory_iterator(config_.root)) {
+        const auto name = entry.path().filename().string();
+        if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        const auto id_str = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+        if (!std::all_of(id_str.begin(), id_str.end(), isdigit)) {
+            continue;
+        }
+        const auto id = static_cast<uint32_t>(std::stoul(id_str));
+        if (auto segment = open_segment(id, false)) {
+            segments_[id] = std::move(segment);
+        }
+    }
+
+    std::ifstream ifs(config_.root + "/" + INDEX_FILE_NAME, std::ios::in | std::ios::binary);
+    uint64_t magic = 0;
+    if (ifs.read(reinterpret_cast<char *>(&magic), sizeof(magic)) && magic == INDEX_MAGIC) {
+        IndexRecord record{};
+        while (ifs.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+            const auto iter = segments_.find(record.segment_id);
+            const auto end = record.offset + record.sample_count * sizeof(float);
+            if (iter == segments_.end() || end > iter->second->capacity) {
+                continue;
+            }
+            iter->second->size = std::max(iter->second->size, end);
+            records_[record.key] = record;
+        }
+    } else if (!segments_.empty()) {
+        spdlog::warn("Audio cache index missing or invalid, segments will be overwritten: {}", config_.root);
+    }
+    ifs.close();
+
+    evict();
+    rewrite_index();
+}
+
+void AudioCache::evict() {
+    const auto total_bytes = [this] {
+        uint64_t bytes = 0;
+        for (const auto &pair : segments_) {
+            bytes += pair.second->capacity;
+        }
+        return bytes;
+    };
+
+    bool evicted = false;
+    while (segments_.size() > 1 && total_bytes() > config_.max_bytes) {
+        const auto oldest = segments_.begin();
+        for (auto iter = records_.begin(); iter != records_.end();) {
+            iter = iter->second.segment_id == oldest->first ? records_.erase(iter) : std::next(iter);
+        }
+        // Readers still holding samples keep the mapping, the file itself can go.
+        fs::remove(oldest->second->path);
+        spdlog::debug("Evict audio cache segment: {}", oldest->second->path);
+        segments_.erase(oldest);
+        evicted = true;
+    }
+    if (evicted && index_.is_open()) {
+        rewrite_index();
+    }
+}
+
+void AudioCache::rewrite_index() {
+    const auto index_path = config_.root + "/" + INDEX_FILE_NAME;
+    const auto temp_path = index_path + ".tmp";
+    index_.close();
+    {
+        std::ofstream ofs(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char *>(&INDEX_MAGIC), sizeof(INDEX_MAGIC));
+        for (const auto &pair : records_) {
+            ofs.write(reinterpret_cast<const char *>(&pair.second), sizeof(pair.second));
+        }
+    }
+    fs::rename(temp_path, index_path);
+    index_.open(index_path, std::ios::out | std::ios::binary | std::ios::app);
+    if (!index_.is_open()) {
+        spdlog::error("Open audio cache index failed! target path: {}", index_path);
+    }
+}
+
+} // namespace lisa::model
@@ -0,0 +1,173 @@
+// cute-giggle@outlook.com
+
+#include "model/melo/batcher.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+#include "model/melo/executor.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+namespace lisa::model {
+
+MeloBatcher::MeloBatcher(std::shared_ptr<Executor> executor, const Config &config)
+    : executor_(std::move(executor)), config_(config) {
+    assert(executor_ != nullptr);
+    config_.max_batch_size = std::max(config_.max_batch_size, 1U);
+    thread_ = std::thread(&MeloBatcher::run, this);
+}
+
+MeloBatcher::~MeloBatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::future<std::vector<float>> MeloBatcher::submit(InputData input) {
+    Request request;
+    const auto iter = input.find(SHARED_INPUT_NAME);
+    request.speed = iter == input.end() ? 1.0f : *reinterpret_cast<const float *>(iter->second.buffer.data());
+    request.input = std::move(input);
+    request.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.max_delay_ms);
+    auto result = request.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(request));
+    }
+    cv_.notify_one();
+    return result;
+}
+
+void MeloBatcher::run() {
+    while (true) {
+        std::vector<Request> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;
+            }
+            const auto deadline = pending_.front().deadline;
+            const auto max_batch_size = batching_ ? config_.max_batch_size : 1U;
+            cv_.wait_until(lock, deadline, [&] { return !running_ || pending_.size() >= max_batch_size; });
+
+            const auto speed = pending_.front().speed;
+            for (auto iter = pending_.begin(); iter != pending_.end() && batch.size() < max_batch_size;) {
+                if (iter->speed != speed) {
+                    ++iter;
+                    continue;
+                }
+                batch.push_back(std::move(*iter));
+                iter = pending_.erase(iter);
+            }
+        }
+        process(batch);
+    }
+}
+
+void MeloBatcher::process(std::vector<Request> &batch) {
+    assert(!batch.empty());
+    const auto start = lisa::utils::current_ts_ms();
+
+    OutputData output;
+    const auto input = batch.size() == 1 ? std::move(batch.front().input) : collate(batch);
+    if (!executor_->infer(input, output) || output.count(MeloExecutor::OUTPUT_NAME) == 0) {
+        spdlog::error("Melo batcher infer failed, batch size: {}", batch.size());
+        for (auto &request : batch) {
+            request.promise.set_value({});
+        }
+        return;
+    }
+
+    // Without the length of each item its padding cannot be told from audio, so
+    // the items run again one by one and nothing is batched from now on.
+    if (batch.size() > 1 && output.count(MeloExecutor::LENGTH_OUTPUT_NAME) == 0) {
+        spdlog::warn("Melo model has no [{}] output, batching disabled", MeloExecutor::LENGTH_OUTPUT_NAME);
+        batching_ = false;
+        for (auto &request : batch) {
+            std::vector<Request> single;
+            single.push_back(std::move(request));
+            process(single);
+        }
+        return;
+    }
+
+    for (auto i = 0U; i < batch.size(); ++i) {
+        batch[i].promise.set_value(slice(output, i, batch.size()));
+    }
+    spdlog::debug("Melo batch done, batch size: {}, time cost: {} ms", batch.size(), lisa::utils::current_ts_ms() - start);
+}
+
+InputData MeloBatcher::collate(const std::vector<Request> &batch) {
+    InputData result;
+    const auto batch_size = batch.size();
+    for (const auto &[name, front] : batch.front().input) {
+        if (name == SHARED_INPUT_NAME) {
+            result[name] = front;
+            continue;
+        }
+        assert(!front.shape.empty() && front.shape[0] == 1);
+        const auto numel = std::accumulate(front.shape.begin(), front.shape.end(), size_t{1}, std::multiplies<>());
+        const auto elem_size = front.buffer.size() / numel;
+
+        // Scalars such as phones_len and speakers become one value per item.
+        if (front.shape.size() == 1) {
+            DataBuffer buffer;
+            buffer.reserve(batch_size * elem_size);
+            for (const auto &request : batch) {
+                const auto &item = request.input.at(name).buffer;
+                buffer.insert(buffer.end(), item.begin(), item.end());
+            }
+            result[name] = Data{std::move(buffer), {batch_size}};
+            continue;
+        }
+
+        // Sequences are zero padded along the last axis to the longest item.
+        size_t max_len = 0;
+        for (const auto &request : batch) {
+            max_len = std::max(max_len, request.input.at(name).shape.back());
+        }
+        const auto rows = numel / front.shape.back();
+        DataShape shape = front.shape;
+        shape.front() = batch_size;
+        shape.back() = max_len;
+        DataBuffer buffer(batch_size * rows * max_len * elem_size, 0);
+        for (auto b = 0U; b < batch_size; ++b) {
+            const auto &item = batch[b].input.at(name);
+            const auto len = item.shape.back();
+            for (auto r = 0U; r < rows; ++r) {
+                std::memcpy(buffer.data() + ((b * rows + r) * max_len) * elem_size,
+                            item.buffer.data() + r * len * elem_size, len * elem_size);
+            }
+        }
+        result[name] = Data{std::move(buffer), std::move(shape)};
+    }
+    return result;
+}
+
+// Item index of count, cut to the length the model reports for it. A batch of
+// one without lengths is taken whole, as MeloModule takes it from the executor.
+std::vector<float> MeloBatcher::slice(const OutputData &output, size_t index, size_t count) {
+    const auto &audio = output.at(MeloExecutor::OUTPUT_NAME).buffer;
+    const auto frames = audio.size() / sizeof(float) / count;
+    const auto data = reinterpret_cast<const float *>(audio.data()) + index * frames;
+    auto size = frames;
+
+    const auto lengths = output.find(MeloExecutor::LENGTH_OUTPUT_NAME);
+    if (lengths != output.end() && lengths->second.buffer.size() == count * sizeof(int64_t)) {
+        const auto length = reinterpret_cast<const int64_t *>(lengths->second.buffer.data())[index];
+        size = std::min<size_t>(std::max<int64_t>(length, 0), frames);
+    }
+    return std::vector<float>(data, data + size);
+}
+
+} // namespace lisa::model
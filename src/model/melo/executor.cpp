@@ -0,0 +1,122 @@
+// cute-giggle@outlook.com
+
+#include "model/melo/executor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+
+#include "openvino/openvino.hpp"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+namespace lisa::model {
+
+MeloExecutor::MeloExecutor(const std::string &model_path, const Config &config) {
+    assert(std::filesystem::exists(model_path));
+    core_ = std::make_unique<ov::Core>();
+    if (!config.cache_dir.empty()) {
+        core_->set_property({ov::cache_dir(config.cache_dir)});
+    }
+
+    ov::AnyMap properties;
+    if (!config.performance_hint.empty()) {
+        properties[ov::hint::performance_mode.name()] = config.performance_hint;
+    }
+    if (config.num_streams != 0) {
+        properties.emplace(ov::num_streams(config.num_streams < 0 ? ov::streams::AUTO : ov::streams::Num(config.num_streams)));
+    }
+    if (config.inference_threads > 0) {
+        properties.emplace(ov::inference_num_threads(config.inference_threads));
+    }
+    if (config.cpu_pinning >= 0) {
+        properties.emplace(ov::hint::enable_cpu_pinning(config.cpu_pinning != 0));
+    }
+    if (config.request_count > 0) {
+        properties.emplace(ov::hint::num_requests(config.request_count));
+    }
+
+    const auto start = lisa::utils::current_ts_ms();
+    compiled_model_ = std::make_unique<ov::CompiledModel>(core_->compile_model(model_path, config.device, properties));
+    spdlog::info("Compile melo model done, device: {}, time cost: {} ms", config.device,
+                 lisa::utils::current_ts_ms() - start);
+
+    auto request_count = config.request_count;
+    if (request_count == 0) {
+        request_count = compiled_model_->get_property(ov::optimal_number_of_infer_requests);
+    }
+    request_count = std::max(request_count, 1U);
+    for (auto i = 0U; i < request_count; ++i) {
+        requests_.push_back(std::make_unique<ov::InferRequest>(compiled_model_->create_infer_request()));
+        idle_requests_.push_back(requests_.back().get());
+    }
+    report_properties();
+}
+
+MeloExecutor::~MeloExecutor() = default;
+
+bool MeloExecutor::infer(const InputData &input, OutputData &output) {
+    auto request = acquire_request();
+    assert(request != nullptr);
+
+    for (const auto &port : compiled_model_->inputs()) {
+        const auto &name = port.get_any_name();
+        const auto iter = input.find(name);
+        if (iter == input.end()) {
+            spdlog::error("Melo executor missing input: {}", name);
+            release_request(request);
+            return false;
+        }
+        auto data = const_cast<uint8_t *>(iter->second.buffer.data());
+        request->set_tensor(port, ov::Tensor(port.get_element_type(), iter->second.shape, data));
+    }
+
+    const auto start = lisa::utils::current_ts_ms();
+    request->infer();
+    spdlog::debug("Infer request done, time cost: {} ms", lisa::utils::current_ts_ms() - start);
+
+    for (const auto &port : compiled_model_->outputs()) {
+        const auto tensor = request->get_tensor(port);
+        const auto shape = tensor.get_shape();
+        DataBuffer buffer(tensor.get_byte_size());
+        std::memcpy(buffer.data(), tensor.data(), buffer.size());
+        output[port.get_any_name()] = Data{std::move(buffer), DataShape(shape.begin(), shape.end())};
+    }
+
+    release_request(request);
+    return true;
+}
+
+void MeloExecutor::report_properties() const {
+    static constexpr const char *names[] = {
+        "PERFORMANCE_HINT", "NUM_STREAMS", "INFERENCE_NUM_THREADS", "ENABLE_CPU_PINNING", "EXECUTION_DEVICES",
+    };
+    for (const auto name : names) {
+        // Not every device reports every property, e.g. AUTO hides the CPU stream settings.
+        try {
+            spdlog::info("Melo executor property {}: {}", name, compiled_model_->get_property(name).as<std::string>());
+        } catch (const std::exception &) {
+            spdlog::debug("Melo executor property {} not supported", name);
+        }
+    }
+    spdlog::info("Melo executor infer requests: {}", requests_.size());
+}
+
+ov::InferRequest *MeloExecutor::acquire_request() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !idle_requests_.empty(); });
+    auto request = idle_requests_.front();
+    idle_requests_.pop_front();
+    return request;
+}
+
+void MeloExecutor::release_request(ov::InferRequest *request) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_requests_.push_back(request);
+    }
+    cv_.notify_one();
+}
+
+} // namespace lisa::model
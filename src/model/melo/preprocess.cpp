@@ -4,16 +4,20 @@
 
 #include <algorithm>
 #include <cstring>
-#include <unordered_set>
 
 #include "language/language.h"
 #include "language/normalize.h"
+#include "language/symbol.h"
 #include "spdlog/spdlog.h"
+#include "utils/arena.h"
+#include "utils/lookup.h"
 #include "utils/string.h"
 
 namespace lisa::model {
 
-const std::unordered_map<std::string, uint32_t> MeloPreprocessor::symbol_id_mapper_ = {
+namespace {
+
+constexpr lisa::utils::SymbolEntry<uint32_t> SYMBOL_ID_LIST[] = {
     {" ", 0},     {"AA", 1},   {"E", 2},    {"EE", 3},    {"En", 4},   {"N", 5},    {"OO", 6},    {"V", 7},   {"a", 8},
     {"a:", 9},    {"aa", 10},  {"ae", 11},  {"ah", 12},   {"ai", 13},  {"an", 14},  {"ang", 15},  {"ao", 16}, {"aw", 17},
     {"ay", 18},   {"b", 19},   {"by", 20},  {"c", 21},    {"ch", 22},  {"d", 23},   {"dh", 24},   {"dy", 25}, {"e", 26},
@@ -29,18 +33,33 @@ const std::unordered_map<std::string, uint32_t> MeloPreprocessor::symbol_id_mapp
     {"'", 108},   {"-", 109},  {"SP", 110}, {"UNK", 111},
 };
 
+constexpr lisa::utils::PerfectHash symbol_id_mapper{SYMBOL_ID_LIST};
+
+constexpr uint32_t UNK_SYMBOL_ID = *symbol_id_mapper.find("UNK");
+
+} // namespace
+
 std::vector<std::string> MeloPreprocessor::split(const std::string &sentence, size_t min_len) const {
+    const auto key = std::to_string(lisa::language::LanguageHelper::instance().lexicon_hash()) + '|' +
+                     std::to_string(min_len) + '|' + sentence;
+    auto sentences = split_cache().get(key);
+    if (!sentences) {
+        sentences = split_cache().put(key, split_uncached(sentence, min_len));
+    }
+    return *sentences;
+}
+
+std::vector<std::string> MeloPreprocessor::split_uncached(const std::string &sentence, size_t min_len) const {
     std::string temp;
     std::vector<std::string> result;
     const auto norm_sentence = lisa::SentenceNormalizer::normalize(sentence);
-    static const std::unordered_set<char> sep_set = lisa::SentenceNormalizer::get_supported_punctuations();
 
     for (const auto &c : norm_sentence) {
         if (c == ' ' && temp.empty()) {
             continue;
         }
         temp.push_back(c);
-        if (sep_set.find(c) == sep_set.end()) {
+        if (!lisa::SentenceNormalizer::is_supported_punctuation(static_cast<uint8_t>(c))) {
             continue;
         }
         if (temp.size() >= min_len) {
@@ -60,23 +79,74 @@ std::vector<std::string> MeloPreprocessor::split(const std::string &sentence, si
     return result;
 }
 
-lisa::model::InputData MeloPreprocessor::preprocess(const std::string &text, float speed) const {
-    std::string temp = " " + text + " ";
-    const auto pronounces = lisa::language::LanguageHelper::instance().pronounce(temp);
+MeloPreprocessor::PhonemeCache &MeloPreprocessor::phoneme_cache() {
+    static PhonemeCache cache(PHONEME_CACHE_CAPACITY, PHONEME_CACHE_SHARDS,
+                              [](const std::string &key, const PhonemeSequence &value) {
+                                  const auto count = value.phones.size() + value.tones.size() + value.langs.size();
+                                  return sizeof(PhonemeSequence) + key.capacity() + count * sizeof(int64_t);
+                              });
+    return cache;
+}
+
+MeloPreprocessor::SplitCache &MeloPreprocessor::split_cache() {
+    static SplitCache cache(PHONEME_CACHE_CAPACITY, PHONEME_CACHE_SHARDS,
+                            [](const std::string &key, const std::vector<std::string> &value) {
+                                auto bytes = sizeof(std::vector<std::string>) + key.capacity();
+                                for (const auto &sentence : value) {
+                                    bytes += sizeof(std::string) + sentence.capacity();
+                                }
+                                return bytes;
+                            });
+    return cache;
+}
 
-    std::vector<int64_t> phones;
-    std::vector<int64_t> tones;
-    std::vector<int64_t> langs;
+MeloPreprocessor::PhonemeCache::Stats MeloPreprocessor::phoneme_cache_stats() { return phoneme_cache().stats(); }
 
-    for (auto [phone, tone, lang] : pronounces) {
-        langs.push_back(ZH_LANG_ID);
-        phones.push_back(get_symbol_id(phone));
-        tones.push_back(lang == lisa::language::Language::EN ? tone + EN_TONE_START : tone + ZH_TONE_START);
+MeloPreprocessor::SplitCache::Stats MeloPreprocessor::split_cache_stats() { return split_cache().stats(); }
+
+void MeloPreprocessor::clear_caches() {
+    phoneme_cache().clear();
+    split_cache().clear();
+}
+
+MeloPreprocessor::PhonemeSequence MeloPreprocessor::phonemize(const std::string &text,
+                                                              std::pmr::memory_resource *arena) const {
+    std::pmr::string temp(arena);
+    temp.reserve(text.size() + 2);
+    temp.append(1, ' ').append(text).push_back(' ');
+    // Reused across calls on the same thread, pronounce only appends to a std::vector.
+    thread_local std::vector<lisa::language::PronounceId> pronounces;
+    pronounces.clear();
+    lisa::language::LanguageHelper::instance().pronounce(temp, pronounces, arena);
+
+    // Cached, so owned rather than taken from the arena.
+    PhonemeSequence result;
+    const auto size = pronounces.size() * 2 + 1;
+    result.langs.assign(size, 0);
+    result.phones.assign(size, 0);
+    result.tones.assign(size, 0);
+    for (auto i = 0U; i < pronounces.size(); ++i) {
+        const auto &[phone, tone, lang] = pronounces[i];
+        result.langs[i * 2 + 1] = ZH_LANG_ID;
+        result.phones[i * 2 + 1] = get_symbol_id(phone);
+        result.tones[i * 2 + 1] = lang == lisa::language::Language::EN ? tone + EN_TONE_START : tone + ZH_TONE_START;
     }
+    return result;
+}
 
-    tones = add_blank(tones);
-    langs = add_blank(langs);
-    phones = add_blank(phones);
+lisa::model::InputData MeloPreprocessor::preprocess(const std::string &text, float speed,
+                                                    std::pmr::memory_resource *arena) const {
+    // Taken before phonemizing, a reload in between files new phones under the
+    // old hash rather than old phones under the new one.
+    const auto key = std::to_string(lisa::language::LanguageHelper::instance().lexicon_hash()) + '|' + text;
+    auto sequence = phoneme_cache().get(key);
+    if (!sequence && arena != nullptr) {
+        sequence = phoneme_cache().put(key, phonemize(text, arena));
+    } else if (!sequence) {
+        lisa::utils::Arena own_arena;
+        sequence = phoneme_cache().put(key, phonemize(text, own_arena.resource()));
+    }
+    const auto &[phones, tones, langs] = *sequence;
 
     std::vector<uint8_t> phones_buffer(phones.size() * sizeof(int64_t));
     std::copy(phones.begin(), phones.end(), reinterpret_cast<int64_t *>(phones_buffer.data()));
@@ -112,13 +182,30 @@ lisa::model::InputData MeloPreprocessor::preprocess(const std::string &text, flo
     return result;
 }
 
-uint32_t MeloPreprocessor::get_symbol_id(const std::string &symbol) const {
-    auto it = symbol_id_mapper_.find(symbol);
-    if (it == symbol_id_mapper_.end()) {
-        spdlog::warn("Melo preprocess unknown symbol: {}", symbol);
-        return symbol_id_mapper_.at("UNK");
+const std::vector<int32_t> &MeloPreprocessor::symbol_id_table() {
+    static const auto table = [] {
+        auto &symbol_table = lisa::language::SymbolTable::instance();
+        std::vector<int32_t> result;
+        for (const auto &[symbol, id] : symbol_id_mapper.entries()) {
+            const auto index = symbol_table.intern(symbol);
+            if (index >= result.size()) {
+                result.resize(index + 1, -1);
+            }
+            result[index] = static_cast<int32_t>(id);
+        }
+        return result;
+    }();
+    return table;
+}
+
+uint32_t MeloPreprocessor::get_symbol_id(uint32_t symbol) const {
+    // Every melo symbol is interned before the table is built, anything beyond it is unknown.
+    const auto &table = symbol_id_table();
+    if (symbol >= table.size() || table[symbol] < 0) {
+        spdlog::warn("Melo preprocess unknown symbol: {}", lisa::language::SymbolTable::instance().name(symbol));
+        return UNK_SYMBOL_ID;
     }
-    return it->second;
+    return table[symbol];
 }
 
 } // namespace doge::model
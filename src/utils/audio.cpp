@@ -0,0 +1,261 @@
+// cute-giggle@outlook.com
+
+#include "utils/audio.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace lisa::utils {
+
+static constexpr float INT16_SCALE = 32767.0f;
+
+static uint32_t xorshift(uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Spreads a seed over all bits, so generators seeded one apart are unrelated.
+static uint32_t mix(uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x85EBCA6B;
+    value ^= value >> 13;
+    value *= 0xC2B2AE35;
+    value ^= value >> 16;
+    return value | 1;
+}
+
+// Difference of two uniform values, in (-1, 1) LSB.
+static float dither(uint32_t &seed) {
+    const auto bits = xorshift(seed);
+    return static_cast<float>(bits >> 16) * (1.0f / 65536.0f) - static_cast<float>(bits & 0xFFFF) * (1.0f / 65536.0f);
+}
+
+AudioLevel audio_level(const float *data, size_t size) {
+    size_t pos = 0;
+    float peak = 0.0f;
+    double sum = 0.0;
+#if defined(__SSE2__)
+    const auto abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    auto peak4 = _mm_setzero_ps();
+    auto sum_lo = _mm_setzero_pd();
+    auto sum_hi = _mm_setzero_pd();
+    for (; pos + 4 <= size; pos += 4) {
+        const auto samples = _mm_loadu_ps(data + pos);
+        peak4 = _mm_max_ps(peak4, _mm_and_ps(samples, abs_mask));
+        const auto squares = _mm_mul_ps(samples, samples);
+        sum_lo = _mm_add_pd(sum_lo, _mm_cvtps_pd(squares));
+        sum_hi = _mm_add_pd(sum_hi, _mm_cvtps_pd(_mm_movehl_ps(squares, squares)));
+    }
+    alignas(16) float peaks[4];
+    alignas(16) double sums[2];
+    _mm_store_ps(peaks, peak4);
+    _mm_store_pd(sums, _mm_add_pd(sum_lo, sum_hi));
+    peak = std::max({peaks[0], peaks[1], peaks[2], peaks[3]});
+    sum = sums[0] + sums[1];
+#endif
+    for (; pos < size; ++pos) {
+        peak = std::max(peak, std::fabs(data[pos]));
+        sum += static_cast<double>(data[pos]) * data[pos];
+    }
+    return {peak, size == 0 ? 0.0f : static_cast<float>(std::sqrt(sum / size))};
+}
+
+void apply_gain(float *data, size_t size, float begin, float end) {
+    if (size == 0) {
+        return;
+    }
+    const auto step = (end - begin) / size;
+    size_t pos = 0;
+#if defined(__SSE2__)
+    auto gain = _mm_add_ps(_mm_set1_ps(begin), _mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)));
+    const auto gain_step = _mm_set1_ps(step * 4);
+    for (; pos + 4 <= size; pos += 4) {
+        _mm_storeu_ps(data + pos, _mm_mul_ps(_mm_loadu_ps(data + pos), gain));
+        gain = _mm_add_ps(gain, gain_step);
+    }
+#endif
+    for (; pos < size; ++pos) {
+        data[pos] *= begin + step * pos;
+    }
+}
+
+// head + (tail - head) * (1 - w), w rising from 0 to 1 across the samples.
+void crossfade(const float *tail, float *head, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    const auto step = 1.0f / size;
+    size_t pos = 0;
+#if defined(__SSE2__)
+    auto weight = _mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+    const auto weight_step = _mm_set1_ps(step * 4);
+    const auto one = _mm_set1_ps(1.0f);
+    for (; pos + 4 <= size; pos += 4) {
+        const auto in = _mm_loadu_ps(head + pos);
+        const auto out = _mm_loadu_ps(tail + pos);
+        _mm_storeu_ps(head + pos, _mm_add_ps(in, _mm_mul_ps(_mm_sub_ps(out, in), _mm_sub_ps(one, weight))));
+        weight = _mm_add_ps(weight, weight_step);
+    }
+#endif
+    for (; pos < size; ++pos) {
+        const auto weight = step * (pos + 0.5f);
+        head[pos] += (tail[pos] - head[pos]) * (1.0f - weight);
+    }
+}
+
+size_t leading_silence(const float *data, size_t size, float threshold) {
+    size_t pos = 0;
+#if defined(__SSE2__)
+    const auto abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const auto limit = _mm_set1_ps(threshold);
+    for (; pos + 4 <= size; pos += 4) {
+        const auto mask = _mm_movemask_ps(_mm_cmpgt_ps(_mm_and_ps(_mm_loadu_ps(data + pos), abs_mask), limit));
+        if (mask != 0) {
+            return pos + __builtin_ctz(static_cast<uint32_t>(mask));
+        }
+    }
+#endif
+    while (pos < size && std::fabs(data[pos]) <= threshold) {
+        ++pos;
+    }
+    return pos;
+}
+
+size_t trailing_silence(const float *data, size_t size, float threshold) {
+    auto pos = size;
+#if defined(__SSE2__)
+    const auto abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const auto limit = _mm_set1_ps(threshold);
+    for (; pos >= 4; pos -= 4) {
+        const auto mask = _mm_movemask_ps(_mm_cmpgt_ps(_mm_and_ps(_mm_loadu_ps(data + pos - 4), abs_mask), limit));
+        if (mask != 0) {
+            return size - (pos - 4 + 31 - __builtin_clz(static_cast<uint32_t>(mask))) - 1;
+        }
+    }
+#endif
+    while (pos > 0 && std::fabs(data[pos - 1]) <= threshold) {
+        --pos;
+    }
+    return size - pos;
+}
+
+void float_to_int16(const float *data, size_t size, int16_t *result, uint32_t &seed) {
+    if (seed == 0) {
+        seed = 0x9E3779B9;
+    }
+    size_t pos = 0;
+#if defined(__SSE2__)
+    if (size >= 8) {
+        // Four independent generators, one per lane, seeded from the caller's.
+        alignas(16) uint32_t seeds[4];
+        for (auto i = 0U; i < 4; ++i) {
+            seeds[i] = mix(seed + i);
+        }
+        auto state = _mm_load_si128(reinterpret_cast<const __m128i *>(seeds));
+        const auto low_mask = _mm_set1_epi32(0xFFFF);
+        const auto unit = _mm_set1_ps(1.0f / 65536.0f);
+        const auto scale = _mm_set1_ps(INT16_SCALE);
+        const auto high = _mm_set1_ps(INT16_SCALE);
+        const auto low = _mm_set1_ps(-INT16_SCALE - 1.0f);
+        const auto next_dither = [&]() {
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+            state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+            const auto a = _mm_cvtepi32_ps(_mm_srli_epi32(state, 16));
+            const auto b = _mm_cvtepi32_ps(_mm_and_si128(state, low_mask));
+            return _mm_mul_ps(_mm_sub_ps(a, b), unit);
+        };
+        const auto convert = [&](const float *in) {
+            auto samples = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in), scale), next_dither());
+            return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(samples, low), high));
+        };
+        for (; pos + 8 <= size; pos += 8) {
+            const auto first = convert(data + pos);
+            const auto second = convert(data + pos + 4);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(result + pos), _mm_packs_epi32(first, second));
+        }
+        _mm_store_si128(reinterpret_cast<__m128i *>(seeds), state);
+        seed = seeds[0] | 1;
+    }
+#endif
+    for (; pos < size; ++pos) {
+        const auto sample = std::clamp(data[pos] * INT16_SCALE + dither(seed), -INT16_SCALE - 1.0f, INT16_SCALE);
+        result[pos] = static_cast<int16_t>(std::lrint(sample));
+    }
+}
+
+AudioPostProcessor::AudioPostProcessor(const Config &config) : config_(config) {
+    assert(config_.sample_rate > 0 && config_.peak_limit > 0.0f && config_.max_gain > 0.0f);
+    glide_size_ = static_cast<size_t>(config_.gain_glide_ms * config_.sample_rate / 1000);
+    crossfade_size_ = static_cast<size_t>(config_.crossfade_ms * config_.sample_rate / 1000);
+    trim_margin_ = static_cast<size_t>(config_.trim_margin_ms * config_.sample_rate / 1000);
+}
+
+void AudioPostProcessor::process(std::vector<float> &chunk, bool last) {
+    if (config_.trim && !started_) {
+        const auto silence = leading_silence(chunk.data(), chunk.size(), config_.trim_threshold);
+        chunk.erase(chunk.begin(), chunk.begin() + (silence > trim_margin_ ? silence - trim_margin_ : 0));
+    }
+    if (config_.trim && last) {
+        const auto silence = trailing_silence(chunk.data(), chunk.size(), config_.trim_threshold);
+        chunk.resize(chunk.size() - (silence > trim_margin_ ? silence - trim_margin_ : 0));
+    }
+
+    if (config_.target_rms > 0.0f) {
+        const auto level = audio_level(chunk.data(), chunk.size());
+        auto gain = gain_;
+        if (level.rms > 0.0f) {
+            gain = std::min(config_.target_rms / level.rms, config_.max_gain);
+        }
+        if (level.peak > 0.0f) {
+            gain = std::min(gain, config_.peak_limit / level.peak);
+        }
+        // The first chunk sets the level, later ones glide to theirs from the
+        // previous one.
+        const auto begin = started_ && level.peak > 0.0f ? std::min(gain_, config_.peak_limit / level.peak) : gain;
+        const auto glide = std::min(glide_size_, chunk.size());
+        apply_gain(chunk.data(), glide, begin, gain);
+        apply_gain(chunk.data() + glide, chunk.size() - glide, gain, gain);
+        gain_ = gain;
+    }
+
+    if (!tail_.empty()) {
+        if (chunk.size() < tail_.size()) {
+            chunk.insert(chunk.begin(), tail_.begin(), tail_.end() - chunk.size());
+        }
+        const auto size = std::min(chunk.size(), tail_.size());
+        crossfade(tail_.data() + tail_.size() - size, chunk.data(), size);
+        tail_.clear();
+    }
+
+    if (last) {
+        reset();
+        return;
+    }
+    started_ = true;
+    const auto held = std::min(crossfade_size_, chunk.size());
+    tail_.assign(chunk.end() - held, chunk.end());
+    chunk.resize(chunk.size() - held);
+}
+
+void AudioPostProcessor::flush(std::vector<float> &result) {
+    // Faded out, the next chunk it was held for never came.
+    apply_gain(tail_.data(), tail_.size(), 1.0f, 0.0f);
+    result.insert(result.end(), tail_.begin(), tail_.end());
+    reset();
+}
+
+void AudioPostProcessor::reset() {
+    started_ = false;
+    gain_ = 1.0f;
+    tail_.clear();
+}
+
+} // namespace lisa::utils
@@ -2,8 +2,157 @@
 
 #include "utils/string.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace lisa::utils {
 
+size_t ascii_span_end(std::string_view text, size_t pos) {
+#if defined(__SSE2__)
+    while (pos + 16 <= text.size()) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + pos));
+        const auto mask = _mm_movemask_epi8(chunk);
+        if (mask != 0) {
+            return pos + __builtin_ctz(static_cast<uint32_t>(mask));
+        }
+        pos += 16;
+    }
+#endif
+    while (pos < text.size() && static_cast<uint8_t>(text[pos]) < 0x80) {
+        ++pos;
+    }
+    return pos;
+}
+
+bool utf8_truncated_tail(std::string_view tail) {
+    const auto lead = static_cast<uint8_t>(tail[0]);
+    const size_t length = lead < 0xC2 ? 0 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : lead < 0xF5 ? 4 : 0;
+    if (tail.size() >= length) {
+        return false;
+    }
+    return std::all_of(tail.begin() + 1, tail.end(), [](char ch) { return (static_cast<uint8_t>(ch) & 0xC0) == 0x80; });
+}
+
+bool utf8_decode(std::string_view text, std::wstring &result) {
+    // Never more code points than bytes.
+    result.resize(text.size());
+    auto *out = result.data();
+    size_t pos = 0;
+    while (pos < text.size()) {
+#if defined(__SSE2__)
+        if constexpr (sizeof(wchar_t) == 4) {
+            const __m128i zero = _mm_setzero_si128();
+            while (pos + 16 <= text.size()) {
+                const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + pos));
+                if (_mm_movemask_epi8(chunk) != 0) {
+                    break;
+                }
+                const auto lo = _mm_unpacklo_epi8(chunk, zero);
+                const auto hi = _mm_unpackhi_epi8(chunk, zero);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4), _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), _mm_unpackhi_epi16(hi, zero));
+                pos += 16;
+                out += 16;
+            }
+            if (pos == text.size()) {
+                break;
+            }
+        }
+#endif
+        char32_t ch = 0;
+        const auto length = utf8_sequence(text, pos, ch);
+        if (length == 0) {
+            if (utf8_truncated_tail(text.substr(pos))) {
+                break;
+            }
+            result.clear();
+            return false;
+        }
+        *out++ = static_cast<wchar_t>(ch);
+        pos += length;
+    }
+    result.resize(out - result.data());
+    return true;
+}
+
+bool utf8_encode(std::wstring_view text, std::string &result) {
+    result.resize(text.size() * 4);
+    auto *out = reinterpret_cast<uint8_t *>(result.data());
+    size_t pos = 0;
+    while (pos < text.size()) {
+#if defined(__SSE2__)
+        if constexpr (sizeof(wchar_t) == 4) {
+            const __m128i zero = _mm_setzero_si128();
+            while (pos + 16 <= text.size()) {
+                const auto *in = reinterpret_cast<const __m128i *>(text.data() + pos);
+                const auto a = _mm_loadu_si128(in);
+                const auto b = _mm_loadu_si128(in + 1);
+                const auto c = _mm_loadu_si128(in + 2);
+                const auto d = _mm_loadu_si128(in + 3);
+                const auto high = _mm_srli_epi32(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), 7);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, zero)) != 0xFFFF) {
+                    break;
+                }
+                const auto packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), packed);
+                pos += 16;
+                out += 16;
+            }
+            if (pos == text.size()) {
+                break;
+            }
+        }
+#endif
+        const auto ch = static_cast<uint32_t>(text[pos++]);
+        if (ch < 0x80) {
+            *out++ = static_cast<uint8_t>(ch);
+        } else if (ch < 0x800) {
+            *out++ = static_cast<uint8_t>(0xC0 | (ch >> 6));
+            *out++ = static_cast<uint8_t>(0x80 | (ch & 0x3F));
+        } else if (ch < 0x10000) {
+            if (ch >= 0xD800 && ch <= 0xDFFF) {
+                result.clear();
+                return false;
+            }
+            *out++ = static_cast<uint8_t>(0xE0 | (ch >> 12));
+            *out++ = static_cast<uint8_t>(0x80 | ((ch >> 6) & 0x3F));
+            *out++ = static_cast<uint8_t>(0x80 | (ch & 0x3F));
+        } else if (ch <= 0x10FFFF) {
+            *out++ = static_cast<uint8_t>(0xF0 | (ch >> 18));
+            *out++ = static_cast<uint8_t>(0x80 | ((ch >> 12) & 0x3F));
+            *out++ = static_cast<uint8_t>(0x80 | ((ch >> 6) & 0x3F));
+            *out++ = static_cast<uint8_t>(0x80 | (ch & 0x3F));
+        } else {
+            result.clear();
+            return false;
+        }
+    }
+    result.resize(out - reinterpret_cast<uint8_t *>(result.data()));
+    return true;
+}
+
+std::wstring utf8_to_wstring(std::string_view text) {
+    std::wstring result;
+    if (!utf8_decode(text, result)) {
+        throw std::range_error("utf8_to_wstring: malformed UTF-8");
+    }
+    return result;
+}
+
+std::string wstring_to_utf8(std::wstring_view text) {
+    std::string result;
+    if (!utf8_encode(text, result)) {
+        throw std::range_error("wstring_to_utf8: invalid code point");
+    }
+    return result;
+}
+
 std::vector<std::string> string_split_any(const std::string &str, const std::string &delim) {
     std::vector<std::string> result;
     std::string::size_type pos0 = 0;
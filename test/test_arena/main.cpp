@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "language/language.h"
+#include "spdlog/spdlog.h"
+#include "utils/arena.h"
+#include "utils/time.h"
+
+using lisa::language::LanguageHelper;
+using lisa::language::PronounceId;
+
+// Every heap allocation of the process is counted.
+static std::atomic<uint64_t> allocations{0};
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto *pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+// std::pmr::new_delete_resource asks for its alignment explicitly.
+void *operator new(size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto align = std::max(static_cast<size_t>(alignment), sizeof(void *));
+    if (auto *pointer = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+
+void operator delete(void *pointer, size_t) noexcept { std::free(pointer); }
+
+void operator delete(void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+
+static std::vector<std::string> read_lines(const std::string &path) {
+    std::vector<std::string> lines;
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static bool same(const std::vector<PronounceId> &lhs, const std::vector<PronounceId> &rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const auto &a, const auto &b) {
+        return a.phone == b.phone && a.tone == b.tone && a.lang == b.lang;
+    });
+}
+
+// Pronounces the corpus with every temporary taken from the heap one by one,
+// as it was before the arena, and from an arena released once per sentence.
+// Counts heap allocations per sentence and compares throughput, alone and with
+// every core pronouncing at once, where the heap is shared and the arenas are not.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::info);
+
+    const auto current_path = std::filesystem::path(__FILE__).parent_path().string();
+    const std::string path = argc > 1 ? argv[1] : current_path + "/../../data/normalize/golden.txt";
+    const auto sentences = read_lines(path);
+    if (sentences.empty()) {
+        spdlog::error("No sentences in: {}", path);
+        return 1;
+    }
+    const auto &helper = LanguageHelper::instance();
+    helper.ready().get();
+
+    auto *heap = std::pmr::new_delete_resource();
+    std::vector<std::vector<PronounceId>> expected(sentences.size());
+    for (auto i = 0U; i < sentences.size(); ++i) {
+        helper.pronounce(sentences[i], expected[i], heap);
+    }
+
+    // One pass over the corpus, result keeps its capacity so only temporaries count.
+    const auto run = [&](std::pmr::memory_resource *resource, lisa::utils::Arena *arena, size_t &mismatches) {
+        std::vector<PronounceId> result;
+        result.reserve(4096);
+        for (auto i = 0U; i < sentences.size(); ++i) {
+            result.clear();
+            helper.pronounce(sentences[i], result, resource);
+            mismatches += same(result, expected[i]) ? 0 : 1;
+            if (arena != nullptr) {
+                arena->release();
+            }
+        }
+    };
+
+    auto failures = 0U;
+    const auto loops = 5U;
+    lisa::utils::Arena arena;
+    uint64_t heap_allocations = 0;
+    uint64_t arena_allocations = 0;
+    for (const auto use_arena : {false, true}) {
+        size_t mismatches = 0;
+        const auto before = allocations.load();
+        const auto start = lisa::utils::current_ts_us();
+        for (auto loop = 0U; loop < loops; ++loop) {
+            run(use_arena ? arena.resource() : heap, use_arena ? &arena : nullptr, mismatches);
+        }
+        const auto cost = (lisa::utils::current_ts_us() - start) / loops;
+        const auto count = (allocations.load() - before) / loops;
+        (use_arena ? arena_allocations : heap_allocations) = count;
+        failures += mismatches == 0 ? 0 : 1;
+        spdlog::info("{}, allocations: {:.1f} per sentence, mismatches: {}, time cost: {} us per pass",
+                     use_arena ? "Arena" : "Heap", double(count) / sentences.size(), mismatches, cost);
+    }
+    // What is left is the segmenter's own strings for words too long to be stored inline.
+    failures += arena_allocations * 4 < heap_allocations ? 0 : 1;
+    spdlog::info("Allocations down from {} to {} per pass", heap_allocations, arena_allocations);
+
+    // Every core pronouncing at once, an arena per thread.
+    const auto thread_count = std::max(4U, std::thread::hardware_concurrency());
+    for (const auto use_arena : {false, true}) {
+        std::atomic<size_t> mismatches{0};
+        std::vector<std::thread> threads;
+        const auto start = lisa::utils::current_ts_us();
+        for (auto t = 0U; t < thread_count; ++t) {
+            threads.emplace_back([&] {
+                lisa::utils::Arena own_arena;
+                size_t own_mismatches = 0;
+                for (auto loop = 0U; loop < loops; ++loop) {
+                    run(use_arena ? own_arena.resource() : heap, use_arena ? &own_arena : nullptr, own_mismatches);
+                }
+                mismatches += own_mismatches;
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        const auto cost = lisa::utils::current_ts_us() - start;
+        failures += mismatches == 0 ? 0 : 1;
+        spdlog::info("{} on {} threads, mismatches: {}, {:.0f} sentences/s", use_arena ? "Arena" : "Heap", thread_count,
+                     mismatches.load(), double(sentences.size()) * loops * thread_count / std::max<double>(cost, 1) * 1e6);
+    }
+
+    spdlog::info("Failures: {}", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -1,21 +1,18 @@
 #include "module/whisper_module.h"
-#include "sndfile.h"
 #include "message/message_pool.h"
+#include "utils/io.h"
 
 #include <iostream>
 
 int main() {
     std::vector<float> pcmf32;
     constexpr auto wav_path = "jfk.wav";
-    SF_INFO sfinfo;
-    SNDFILE *sf = sf_open(wav_path, SFM_READ, &sfinfo);
-    if (sf == nullptr) {
+    lisa::utils::WavReader reader(wav_path);
+    if (!reader.is_open()) {
         fprintf(stderr, "failed to open '%s'\n", wav_path);
         return 1;
     }
-    pcmf32.resize(sfinfo.frames * sfinfo.channels);
-    sf_readf_float(sf, pcmf32.data(), pcmf32.size());
-    sf_close(sf);
+    reader.read(pcmf32, reader.frames());
     printf("Read %lu samples\n", pcmf32.size());
     if (pcmf32.size() < 16000) {
         pcmf32.resize(32000);
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+#include "utils/audio.h"
+#include "utils/time.h"
+
+static constexpr uint32_t SAMPLE_RATE = 44100;
+
+// Speech like chunk: a tone with a random level and phase, so consecutive chunks
+// jump at the seam, between padding of silence.
+static std::vector<float> make_chunk(std::mt19937 &rng, size_t size, size_t padding) {
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    const auto level = 0.02f + 0.6f * uniform(rng);
+    const auto frequency = 120.0f + 300.0f * uniform(rng);
+    const auto phase = 6.2832f * uniform(rng);
+    std::vector<float> chunk(size, 0.0f);
+    for (auto i = padding; i + padding < size; ++i) {
+        chunk[i] = level * std::sin(phase + 6.2832f * frequency * i / SAMPLE_RATE);
+    }
+    return chunk;
+}
+
+static float max_step(const std::vector<float> &audio, size_t pos) {
+    return pos == 0 || pos >= audio.size() ? 0.0f : std::fabs(audio[pos] - audio[pos - 1]);
+}
+
+// Checks the SIMD kernels against plain loops on every small size and alignment,
+// then runs utterances through AudioPostProcessor: seams, level, trimming, and
+// the time it takes next to the audio it produces.
+int main() {
+    spdlog::set_level(spdlog::level::info);
+
+    std::mt19937 rng(20241019);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    auto failures = 0U;
+    std::vector<float> buffer(80);
+    for (auto &sample : buffer) {
+        sample = uniform(rng);
+    }
+    for (size_t offset = 0; offset < 4; ++offset) {
+        for (size_t size = 0; size + offset <= 72; ++size) {
+            const auto *data = buffer.data() + offset;
+            float peak = 0.0f;
+            double sum = 0.0;
+            for (size_t i = 0; i < size; ++i) {
+                peak = std::max(peak, std::fabs(data[i]));
+                sum += double(data[i]) * data[i];
+            }
+            const auto level = lisa::utils::audio_level(data, size);
+            const auto rms = size == 0 ? 0.0 : std::sqrt(sum / size);
+            failures += level.peak == peak && std::fabs(level.rms - rms) < 1e-6 ? 0 : 1;
+
+            std::vector<float> gained(data, data + size);
+            lisa::utils::apply_gain(gained.data(), size, 0.5f, 2.0f);
+            std::vector<float> faded(data, data + size);
+            lisa::utils::crossfade(buffer.data() + 8, faded.data(), size);
+            for (size_t i = 0; i < size; ++i) {
+                const auto gain = 0.5f + 1.5f * i / size;
+                const auto weight = (i + 0.5f) / size;
+                const auto mixed = buffer[8 + i] * (1.0f - weight) + data[i] * weight;
+                failures += std::fabs(gained[i] - data[i] * gain) < 1e-5f && std::fabs(faded[i] - mixed) < 1e-5f ? 0 : 1;
+            }
+
+            for (size_t loud = 0; loud <= size; ++loud) {
+                std::vector<float> quiet(size, 0.001f);
+                if (loud < size) {
+                    quiet[loud] = -0.5f;
+                }
+                failures += lisa::utils::leading_silence(quiet.data(), size, 0.01f) == loud ? 0 : 1;
+                failures += lisa::utils::trailing_silence(quiet.data(), size, 0.01f) == (loud < size ? size - loud - 1 : size)
+                                ? 0
+                                : 1;
+            }
+        }
+    }
+
+    // Dither keeps every sample within one LSB of the exact value and the error
+    // unbiased, and overloads saturate.
+    std::vector<float> ramp(SAMPLE_RATE);
+    for (size_t i = 0; i < ramp.size(); ++i) {
+        ramp[i] = -1.2f + 2.4f * i / ramp.size();
+    }
+    std::vector<int16_t> pcm(ramp.size());
+    uint32_t seed = 0;
+    lisa::utils::float_to_int16(ramp.data(), ramp.size(), pcm.data(), seed);
+    double error_sum = 0.0;
+    double error_max = 0.0;
+    size_t in_range = 0;
+    for (size_t i = 0; i < ramp.size(); ++i) {
+        const auto exact = std::clamp(ramp[i] * 32767.0, -32768.0, 32767.0);
+        const auto error = pcm[i] - exact;
+        if (std::fabs(ramp[i]) < 0.99f) {
+            error_sum += error;
+            error_max = std::max(error_max, std::fabs(error));
+            ++in_range;
+        }
+        failures += std::fabs(error) < 1.5 ? 0 : 1;
+    }
+    spdlog::info("Kernels checked, int16 error max: {:.2f} LSB, mean: {:+.4f} LSB, failures: {}", error_max,
+                 error_sum / in_range, failures);
+
+    // Utterances of 8 chunks of 1 to 3 seconds, the first and last one padded with
+    // a quarter second of silence, the inner ones cut mid tone like the seams of a
+    // long sentence.
+    lisa::utils::AudioPostProcessor::Config config;
+    config.sample_rate = SAMPLE_RATE;
+    lisa::utils::AudioPostProcessor processor(config);
+    const auto chunks_per_utterance = 8U;
+    const auto utterances = 40U;
+    float raw_seam = 0.0f;
+    float post_seam = 0.0f;
+    float post_peak = 0.0f;
+    double rms_error = 0.0;
+    size_t leading = 0;
+    size_t trailing = 0;
+    size_t samples = 0;
+    uint64_t post_ns = 0;
+    uint64_t convert_ns = 0;
+    std::uniform_int_distribution<size_t> chunk_size(SAMPLE_RATE, SAMPLE_RATE * 3);
+    for (auto utterance = 0U; utterance < utterances; ++utterance) {
+        std::vector<float> raw;
+        std::vector<float> post;
+        std::vector<size_t> raw_seams;
+        std::vector<size_t> post_seams;
+        for (auto i = 0U; i < chunks_per_utterance; ++i) {
+            const auto padding = i == 0 || i + 1 == chunks_per_utterance ? SAMPLE_RATE / 4 : 0;
+            auto chunk = make_chunk(rng, chunk_size(rng), padding);
+            raw_seams.push_back(raw.size());
+            raw.insert(raw.end(), chunk.begin(), chunk.end());
+
+            const auto begin = lisa::utils::current_ts_ns();
+            processor.process(chunk, i + 1 == chunks_per_utterance);
+            post_ns += lisa::utils::current_ts_ns() - begin;
+            const auto level = lisa::utils::audio_level(chunk.data(), chunk.size());
+            if (i > 0 && i + 1 < chunks_per_utterance) {
+                rms_error = std::max<double>(rms_error, std::fabs(level.rms - config.target_rms) / config.target_rms);
+            }
+            post_peak = std::max(post_peak, level.peak);
+            post_seams.push_back(post.size());
+            post.insert(post.end(), chunk.begin(), chunk.end());
+        }
+        for (auto i = 1U; i < chunks_per_utterance; ++i) {
+            raw_seam = std::max(raw_seam, max_step(raw, raw_seams[i]));
+            // The crossfade spreads the jump, the largest step around the seam counts.
+            for (auto pos = post_seams[i] - 4; pos < post_seams[i] + 4; ++pos) {
+                post_seam = std::max(post_seam, max_step(post, pos));
+            }
+        }
+        leading = std::max(leading, lisa::utils::leading_silence(post.data(), post.size(), config.trim_threshold));
+        trailing = std::max(trailing, lisa::utils::trailing_silence(post.data(), post.size(), config.trim_threshold));
+        samples += post.size();
+
+        pcm.resize(post.size());
+        const auto begin = lisa::utils::current_ts_ns();
+        lisa::utils::float_to_int16(post.data(), post.size(), pcm.data(), seed);
+        convert_ns += lisa::utils::current_ts_ns() - begin;
+    }
+    const auto margin = static_cast<size_t>(config.trim_margin_ms * SAMPLE_RATE / 1000);
+    failures += post_seam < raw_seam / 4 && post_peak <= config.peak_limit + 1e-6f ? 0 : 1;
+    // Trimmed as synthesized, the gain can lift a few samples next to the margin
+    // over the threshold. The glide and crossfades keep chunk levels a little off
+    // target.
+    const auto slack = SAMPLE_RATE / 1000;
+    failures += leading <= margin + slack && trailing <= margin + slack && rms_error < 0.1 ? 0 : 1;
+    spdlog::info("Seam step raw: {:.3f}, post processed: {:.3f}, peak: {:.3f}, chunk rms off target by up to {:.1f}%",
+                 raw_seam, post_seam, post_peak, rms_error * 100);
+    spdlog::info("Silence left at the ends: {} and {} samples, margin: {}", leading, trailing, margin);
+
+    const auto seconds = double(samples) / SAMPLE_RATE;
+    spdlog::info("{:.0f} s of audio, post process: {} us ({:.1f} us per second), int16: {} us ({:.1f} us per second)", seconds,
+                 post_ns / 1000, post_ns / 1000.0 / seconds, convert_ns / 1000, convert_ns / 1000.0 / seconds);
+    spdlog::info("Failures: {}", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "message/message_center.h"
+#include "module/audio_source_module.h"
+#include "spdlog/spdlog.h"
+#include "utils/io.h"
+#include "utils/time.h"
+
+using lisa::module::AudioSourceModule;
+
+static constexpr uint32_t SAMPLE_RATE = 16000;
+
+static std::vector<float> make_signal(size_t size) {
+    std::vector<float> signal(size);
+    for (size_t i = 0; i < size; ++i) {
+        signal[i] = 0.5f * std::sin(0.01f * i) + 0.25f * std::sin(0.37f * i);
+    }
+    return signal;
+}
+
+// Writes the bytes in pieces of random size, as a producer on the other end would.
+static void write_pieces(int fd, const void *data, size_t size) {
+    std::mt19937 rng(size);
+    const auto *bytes = static_cast<const char *>(data);
+    for (size_t pos = 0; pos < size;) {
+        const auto count = write(fd, bytes + pos, std::min<size_t>(size - pos, 1 + rng() % 3000));
+        if (count <= 0) {
+            return;
+        }
+        pos += count;
+    }
+}
+
+struct Received {
+    std::vector<float> samples{};
+    size_t frames{};
+    bool in_order{true};
+    uint64_t elapsed_us{};
+    uint64_t max_late_us{}; // arrival after the frame was due
+};
+
+// Runs a source until it has published samples, or it finishes.
+static Received receive(const std::string &name, const AudioSourceModule::Config &config, size_t samples) {
+    Received result;
+    const auto queue = lisa::message::MessageCenter::instance().get_queue(name + "_out");
+    AudioSourceModule source(name, name + "_out", config);
+    const auto start = lisa::utils::current_ts_us();
+    source.start();
+    while (result.samples.size() < samples && lisa::utils::current_ts_us() - start < 30000000) {
+        auto audio_msg = std::dynamic_pointer_cast<lisa::message::AudioMessage>(queue->wait_for(100));
+        if (!audio_msg) {
+            if (source.finished()) {
+                break;
+            }
+            continue;
+        }
+        const auto now = lisa::utils::current_ts_us();
+        result.max_late_us = std::max(result.max_late_us, now > audio_msg->time_stamp_ ? now - audio_msg->time_stamp_ : 0);
+        result.in_order = result.in_order && audio_msg->sequence_ == result.frames;
+        result.samples.insert(result.samples.end(), audio_msg->samples(), audio_msg->samples() + audio_msg->size());
+        ++result.frames;
+    }
+    result.elapsed_us = lisa::utils::current_ts_us() - start;
+    source.stop();
+    return result;
+}
+
+static float max_error(const std::vector<float> &actual, const std::vector<float> &expected) {
+    if (actual.size() != expected.size()) {
+        return 1.0f;
+    }
+    float error = 0.0f;
+    for (size_t i = 0; i < actual.size(); ++i) {
+        error = std::max(error, std::fabs(actual[i] - expected[i]));
+    }
+    return error;
+}
+
+// Feeds a wav file paced in real time, scaled and unthrottled, repeated, a fifo
+// of 16 bit PCM and a socket of stereo float PCM through AudioSourceModule, and
+// checks every sample arrives in order, on time.
+int main() {
+    spdlog::set_level(spdlog::level::info);
+
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto signal = make_signal(SAMPLE_RATE * 2 + 123);
+    auto failures = 0U;
+
+    const auto wav_path = (directory / "test_audio_source.wav").string();
+    lisa::utils::save_wav(wav_path, signal.data(), signal.size(), SAMPLE_RATE, 1);
+    std::vector<float> stored(signal.size());
+    lisa::utils::WavReader(wav_path).read(stored.data(), stored.size());
+
+    const auto duration_us = signal.size() * 1000000ULL / SAMPLE_RATE;
+    AudioSourceModule::Config config;
+    config.path = wav_path;
+    for (const auto &[pacing, speed] : {std::pair{AudioSourceModule::Pacing::REAL_TIME, 1.0},
+                                        std::pair{AudioSourceModule::Pacing::SCALED, 8.0},
+                                        std::pair{AudioSourceModule::Pacing::UNTHROTTLED, 0.0}}) {
+        config.pacing = pacing;
+        config.speed = speed;
+        const auto name = "wav_" + std::to_string(static_cast<uint32_t>(pacing));
+        const auto result = receive(name, config, stored.size());
+        const auto error = max_error(result.samples, stored);
+        const auto expected_us = speed > 0.0 ? duration_us / speed : 0.0;
+        // Paced sources take their duration, to within a frame and scheduling.
+        const auto on_time = speed == 0.0 || std::fabs(result.elapsed_us - expected_us) < expected_us * 0.05 + 30000;
+        failures += error == 0.0f && result.in_order && on_time ? 0 : 1;
+        spdlog::info("Wav at speed {}, frames: {}, error: {}, in order: {}, time cost: {} ms for {} ms of audio, late "
+                     "by up to {} us",
+                     speed, result.frames, error, result.in_order, result.elapsed_us / 1000, duration_us / 1000,
+                     result.max_late_us);
+    }
+
+    config.pacing = AudioSourceModule::Pacing::UNTHROTTLED;
+    config.repeat = true;
+    auto repeated = receive("wav_repeat", config, stored.size() * 3);
+    repeated.samples.resize(std::min(repeated.samples.size(), stored.size() * 3));
+    std::vector<float> three_times;
+    for (auto i = 0; i < 3; ++i) {
+        three_times.insert(three_times.end(), stored.begin(), stored.end());
+    }
+    failures += max_error(repeated.samples, three_times) == 0.0f ? 0 : 1;
+    spdlog::info("Wav repeated, frames: {}, same as three times the file: {}", repeated.frames,
+                 max_error(repeated.samples, three_times) == 0.0f);
+
+    // 16 bit PCM through a fifo, opened by the source before its writer.
+    const auto fifo_path = (directory / "test_audio_source.fifo").string();
+    std::filesystem::remove(fifo_path);
+    mkfifo(fifo_path.c_str(), 0600);
+    std::vector<int16_t> pcm(signal.size());
+    std::transform(signal.begin(), signal.end(), pcm.begin(),
+                   [](float sample) { return static_cast<int16_t>(std::lrint(sample * 32767.0f)); });
+    std::thread fifo_writer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const auto fd = open(fifo_path.c_str(), O_WRONLY);
+        write_pieces(fd, pcm.data(), pcm.size() * sizeof(int16_t));
+        close(fd);
+    });
+    AudioSourceModule::Config pipe_config;
+    pipe_config.source = AudioSourceModule::Source::PCM_PIPE;
+    pipe_config.path = fifo_path;
+    pipe_config.sample_rate = SAMPLE_RATE;
+    pipe_config.pacing = AudioSourceModule::Pacing::UNTHROTTLED;
+    const auto piped = receive("pipe", pipe_config, pcm.size());
+    fifo_writer.join();
+    std::vector<float> pcm_float(pcm.size());
+    std::transform(pcm.begin(), pcm.end(), pcm_float.begin(), [](int16_t sample) { return sample / 32768.0f; });
+    failures += max_error(piped.samples, pcm_float) == 0.0f && piped.in_order ? 0 : 1;
+    spdlog::info("Fifo of 16 bit PCM, frames: {}, samples: {} of {}, error: {}", piped.frames, piped.samples.size(),
+                 pcm.size(), max_error(piped.samples, pcm_float));
+    std::filesystem::remove(fifo_path);
+
+    // Stereo float PCM from a socket server, started after the source.
+    const auto socket_path = (directory / "test_audio_source.sock").string();
+    std::filesystem::remove(socket_path);
+    std::vector<float> stereo;
+    for (const auto sample : signal) {
+        stereo.push_back(sample);
+        stereo.push_back(-sample);
+    }
+    std::thread server([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::copy(socket_path.begin(), socket_path.end(), address.sun_path);
+        const auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+        listen(listener, 1);
+        const auto fd = accept(listener, nullptr, nullptr);
+        write_pieces(fd, stereo.data(), stereo.size() * sizeof(float));
+        close(fd);
+        close(listener);
+    });
+    AudioSourceModule::Config socket_config = pipe_config;
+    socket_config.source = AudioSourceModule::Source::UNIX_SOCKET;
+    socket_config.path = socket_path;
+    socket_config.channels = 2;
+    socket_config.float_samples = true;
+    socket_config.pacing = AudioSourceModule::Pacing::SCALED;
+    socket_config.speed = 4.0;
+    const auto socketed = receive("socket", socket_config, stereo.size());
+    server.join();
+    failures += max_error(socketed.samples, stereo) == 0.0f && socketed.in_order ? 0 : 1;
+    spdlog::info("Socket of stereo float PCM at speed 4, frames: {}, samples: {} of {}, time cost: {} ms",
+                 socketed.frames, socketed.samples.size(), stereo.size(), socketed.elapsed_us / 1000);
+    std::filesystem::remove(socket_path);
+    std::filesystem::remove(wav_path);
+
+    lisa::message::MessageCenter::instance().shutdown();
+    spdlog::info("Failures: {}", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+#include "utils/io.h"
+#include "utils/time.h"
+
+// read_txt and save_txt as they were, through string streams.
+template <typename T> static std::vector<T> reference_read_txt(const std::string &path, const std::string &seps) {
+    std::ifstream ifs(path, std::ios_base::in);
+    std::vector<T> result;
+    std::string line_buffer;
+    while (std::getline(ifs, line_buffer)) {
+        for (auto sep : seps) {
+            std::replace(line_buffer.begin(), line_buffer.end(), sep, ' ');
+        }
+        std::stringstream ss(line_buffer);
+        std::copy(std::istream_iterator<T>{ss}, std::istream_iterator<T>{}, std::back_inserter(result));
+    }
+    return result;
+}
+
+template <typename T> static void reference_save_txt(const std::string &path, const T *buffer, size_t size, char sep) {
+    std::ofstream ofs(path, std::ios_base::out);
+    for (auto i = 0U; i < size; ++i) {
+        ofs << buffer[i] << sep;
+    }
+}
+
+static std::string read_file(const std::string &path) {
+    std::ifstream ifs(path, std::ios_base::binary);
+    return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+}
+
+template <typename F> static uint64_t time_us(F &&function) {
+    const auto begin = lisa::utils::current_ts_us();
+    function();
+    return std::max<uint64_t>(lisa::utils::current_ts_us() - begin, 1);
+}
+
+// Checks read_txt against the string stream parser it replaced on a large mixed
+// separator file and on odd tokens, save_txt round trips, and .npy files against
+// the layout numpy writes, then compares load times.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::info);
+
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto txt_path = (directory / "test_io.txt").string();
+    const auto npy_path = (directory / "test_io.npy").string();
+    auto failures = 0U;
+
+    // Values over many magnitudes, rows of 64 cut by ',', ';', tabs and spaces.
+    std::mt19937 rng(20241019);
+    std::vector<float> values(count);
+    for (auto &value : values) {
+        value = std::ldexp(std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng), static_cast<int>(rng() % 40) - 20);
+    }
+    {
+        std::ofstream ofs(txt_path);
+        ofs.precision(9);
+        const char *separators[] = {", ", ";", "\t", " ", ",\t"};
+        for (size_t i = 0; i < count; ++i) {
+            ofs << values[i] << (i % 64 == 63 ? (i % 128 == 127 ? "\r\n" : "\n") : separators[rng() % 5]);
+        }
+        ofs << "\n+3 1e-5 -0 7,8\n\n9 abc 10\n11 12x 13\n-4.5e+3;+-1 14\n5.";
+    }
+    std::vector<float> expected;
+    std::vector<float> actual;
+    const auto reference_us = time_us([&]() { expected = reference_read_txt<float>(txt_path, ",;"); });
+    const auto current_us = time_us([&]() { actual = lisa::utils::read_txt<float>(txt_path, ",;"); });
+    failures += actual == expected ? 0 : 1;
+    const auto size_mb = std::filesystem::file_size(txt_path) / 1048576.0;
+    spdlog::info("read_txt of {:.1f} MB, values: {}, same as string streams: {}, reference: {} ms, current: {} ms, "
+                 "speedup: {:.1f}x",
+                 size_mb, actual.size(), actual == expected, reference_us / 1000, current_us / 1000,
+                 double(reference_us) / current_us);
+
+    // Integers too, and the odd tokens on their own.
+    {
+        std::ofstream ofs(txt_path);
+        ofs << "1 -2 +3 4.5 6\n7,8 x 9\n-9223372036854775808 9223372036854775807 99999999999999999999 1\n 10\t11";
+    }
+    const auto integers = lisa::utils::read_txt<int64_t>(txt_path, ",");
+    failures += integers == reference_read_txt<int64_t>(txt_path, ",") ? 0 : 1;
+    spdlog::info("read_txt of integers: [{}]", spdlog::fmt_lib::join(integers, " "));
+
+    // Every float comes back exactly, the stream wrote 6 significant digits.
+    const auto save_reference_us = time_us([&]() { reference_save_txt(txt_path, values.data(), values.size(), ' '); });
+    const auto save_us = time_us([&]() { lisa::utils::save_txt(txt_path, values.data(), values.size(), ' '); });
+    const auto round_trip = lisa::utils::read_txt<float>(txt_path);
+    failures += round_trip == values ? 0 : 1;
+    spdlog::info("save_txt round trips exactly: {}, reference: {} ms, current: {} ms, speedup: {:.1f}x",
+                 round_trip == values, save_reference_us / 1000, save_us / 1000, double(save_reference_us) / save_us);
+
+    // Byte for byte what numpy.save writes for np.arange(6, dtype='<f4').reshape(2, 3).
+    lisa::model::Data small;
+    small.shape = {2, 3};
+    small.buffer.resize(6 * sizeof(float));
+    for (auto i = 0; i < 6; ++i) {
+        reinterpret_cast<float *>(small.buffer.data())[i] = static_cast<float>(i);
+    }
+    lisa::utils::save_npy<float>(npy_path, small);
+    std::string numpy_layout("\x93NUMPY\x01\x00\x76\x00", 10);
+    numpy_layout += "{'descr': '<f4', 'fortran_order': False, 'shape': (2, 3), }";
+    numpy_layout.append(127 - numpy_layout.size(), ' ');
+    numpy_layout.push_back('\n');
+    numpy_layout.append(reinterpret_cast<const char *>(small.buffer.data()), small.buffer.size());
+    failures += read_file(npy_path) == numpy_layout ? 0 : 1;
+    spdlog::info("save_npy layout same as numpy: {}", read_file(npy_path) == numpy_layout);
+
+    // Shapes of every rank round trip, a wrong element type is refused.
+    for (const auto &shape : std::vector<lisa::model::DataShape>{{}, {5}, {3, 4}, {2, 3, 7}, {1, 0}}) {
+        lisa::model::Data data;
+        data.shape = shape;
+        const auto size = std::accumulate(shape.begin(), shape.end(), size_t{1}, std::multiplies<>());
+        data.buffer.resize(size * sizeof(int64_t));
+        for (size_t i = 0; i < size; ++i) {
+            reinterpret_cast<int64_t *>(data.buffer.data())[i] = static_cast<int64_t>(rng()) - (1LL << 31);
+        }
+        lisa::model::Data loaded;
+        const auto saved = lisa::utils::save_npy<int64_t>(npy_path, data);
+        const auto same = lisa::utils::load_npy<int64_t>(npy_path, loaded) && loaded.shape == data.shape &&
+                          loaded.buffer == data.buffer;
+        lisa::model::Data refused;
+        const auto wrong_type = lisa::utils::load_npy<float>(npy_path, refused);
+        failures += saved && same && !wrong_type ? 0 : 1;
+    }
+
+    // Files numpy would not write: truncated inside the version 2 header length,
+    // a shape too large to count, elements not aligned for their type.
+    const auto write_file = [&](const std::string &content) { std::ofstream(npy_path, std::ios_base::binary) << content; };
+    for (const auto size : {10U, 11U}) {
+        write_file(std::string("\x93NUMPY\x02\x00\x40\x00\x00", size));
+        const lisa::utils::NpyFile truncated(npy_path);
+        failures += truncated.is_valid() ? 1 : 0;
+    }
+    std::string huge("\x93NUMPY\x01\x00\x00\x00", 10);
+    const std::string huge_header = "{'descr': '<f4', 'fortran_order': False, 'shape': (4294967296, 4294967296, 16), }\n";
+    huge[8] = static_cast<char>(huge_header.size());
+    write_file(huge + huge_header + std::string(64, '\0'));
+    failures += lisa::utils::NpyFile(npy_path).is_valid() ? 1 : 0;
+
+    const std::vector<int64_t> elements = {-1, 2, -3};
+    std::string misaligned_header = "{'descr': '<i8', 'fortran_order': False, 'shape': (3,), }";
+    // Padded so the elements start 3 bytes past an 8 byte boundary.
+    while ((10 + misaligned_header.size() + 1) % 8 != 3) {
+        misaligned_header.push_back(' ');
+    }
+    misaligned_header.push_back('\n');
+    std::string misaligned("\x93NUMPY\x01\x00", 8);
+    misaligned.push_back(static_cast<char>(misaligned_header.size()));
+    misaligned.push_back('\0');
+    misaligned += misaligned_header;
+    misaligned.append(reinterpret_cast<const char *>(elements.data()), elements.size() * sizeof(int64_t));
+    write_file(misaligned);
+    {
+        const lisa::utils::NpyFile file(npy_path);
+        lisa::model::Data copied;
+        const auto copied_ok = lisa::utils::load_npy<int64_t>(npy_path, copied) &&
+                               copied.shape == lisa::model::DataShape{3} &&
+                               copied.buffer.size() == elements.size() * sizeof(int64_t) &&
+                               std::memcmp(copied.buffer.data(), elements.data(), copied.buffer.size()) == 0;
+        const auto refused = file.is_valid() && file.data<int64_t>() == nullptr;
+        failures += copied_ok && refused ? 0 : 1;
+        spdlog::info("Malformed npy refused, misaligned elements copied: {}, not mapped: {}", copied_ok, refused);
+    }
+
+    // A large fixture used in place, against parsing the same values from text.
+    lisa::model::Data large;
+    large.shape = {count / 64, 64};
+    large.buffer.assign(reinterpret_cast<const uint8_t *>(values.data()),
+                        reinterpret_cast<const uint8_t *>(values.data() + count / 64 * 64));
+    lisa::utils::save_npy<float>(npy_path, large);
+    lisa::utils::save_txt(txt_path, values.data(), count / 64 * 64, ' ');
+    const float *mapped = nullptr;
+    size_t mapped_count = 0;
+    const auto map_us = time_us([&]() {
+        lisa::utils::NpyFile file(npy_path);
+        mapped = file.data<float>();
+        mapped_count = file.element_count();
+        failures += mapped != nullptr && reinterpret_cast<uintptr_t>(mapped) % 64 == 0 &&
+                            std::equal(mapped, mapped + mapped_count, values.begin())
+                        ? 0
+                        : 1;
+    });
+    lisa::model::Data loaded;
+    const auto load_us = time_us([&]() { lisa::utils::load_npy<float>(npy_path, loaded); });
+    const auto text_us = time_us([&]() { actual = lisa::utils::read_txt<float>(txt_path); });
+    failures += loaded.buffer == large.buffer && actual.size() == mapped_count ? 0 : 1;
+    spdlog::info("Fixture of {} floats, mapped and checked: {} us, load_npy: {} us, read_txt: {} us", mapped_count,
+                 map_us, load_us, text_us);
+
+    std::filesystem::remove(txt_path);
+    std::filesystem::remove(npy_path);
+    spdlog::info("Failures: {}", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "language/language.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+using lisa::language::LanguageHelper;
+using lisa::language::PronounceId;
+
+static std::vector<std::string> read_lines(const std::string &path) {
+    std::vector<std::string> lines;
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static bool same(const std::vector<PronounceId> &lhs, const std::vector<PronounceId> &rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const auto &a, const auto &b) {
+        return a.phone == b.phone && a.tone == b.tone && a.lang == b.lang;
+    });
+}
+
+// Hammers LanguageHelper from many threads at once, single sentence calls and
+// overlapping batches, and checks every result against a sequential run. Then
+// measures pronounce_batch throughput for 1, 2, 4, ... workers.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::info);
+
+    const auto current_path = std::filesystem::path(__FILE__).parent_path().string();
+    // Normalized sentences, as pronounce sees them behind MeloPreprocessor.
+    const std::string path = argc > 1 ? argv[1] : current_path + "/../../data/normalize/golden.txt";
+    const auto sentences = read_lines(path);
+    if (sentences.empty()) {
+        spdlog::error("No sentences in: {}", path);
+        return 1;
+    }
+    const auto &helper = LanguageHelper::instance();
+    helper.ready().get();
+
+    std::vector<std::vector<PronounceId>> expected(sentences.size());
+    for (auto i = 0U; i < sentences.size(); ++i) {
+        helper.pronounce(sentences[i], expected[i]);
+    }
+
+    const auto check = [&](const std::vector<std::vector<PronounceId>> &result) {
+        size_t mismatches = result.size() == expected.size() ? 0 : 1;
+        for (auto i = 0U; i < result.size() && i < expected.size(); ++i) {
+            mismatches += same(result[i], expected[i]) ? 0 : 1;
+        }
+        return mismatches;
+    };
+
+    // Stress: half the threads pronounce single sentences in a shuffled order,
+    // the other half run whole batches that compete for the same pool.
+    const auto thread_count = std::max(4U, std::thread::hardware_concurrency());
+    const auto rounds = 3U;
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> threads;
+    auto start = lisa::utils::current_ts_us();
+    for (auto t = 0U; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            if (t % 2 == 0) {
+                for (auto round = 0U; round < rounds; ++round) {
+                    mismatches += check(helper.pronounce_batch(sentences));
+                }
+                return;
+            }
+            std::vector<size_t> order(sentences.size());
+            for (auto i = 0U; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            std::mt19937 rng(t);
+            std::vector<PronounceId> result;
+            for (auto round = 0U; round < rounds; ++round) {
+                std::shuffle(order.begin(), order.end(), rng);
+                for (const auto i : order) {
+                    result.clear();
+                    helper.pronounce(sentences[i], result);
+                    mismatches += same(result, expected[i]) ? 0 : 1;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    spdlog::info("Stress test done, threads: {}, rounds: {}, sentences: {}, mismatches: {}, time cost: {} us",
+                 thread_count, rounds, sentences.size(), mismatches.load(), lisa::utils::current_ts_us() - start);
+    if (mismatches != 0) {
+        return 1;
+    }
+
+    // Scaling, sequential as the baseline.
+    const auto loops = 5U;
+    start = lisa::utils::current_ts_us();
+    for (auto loop = 0U; loop < loops; ++loop) {
+        std::vector<PronounceId> result;
+        for (const auto &sentence : sentences) {
+            result.clear();
+            helper.pronounce(sentence, result);
+        }
+    }
+    const auto sequential = (lisa::utils::current_ts_us() - start) / loops;
+    spdlog::info("Sequential, time cost: {} us per pass", sequential);
+
+    for (size_t workers = 1; workers <= helper.worker_count(); workers *= 2) {
+        start = lisa::utils::current_ts_us();
+        for (auto loop = 0U; loop < loops; ++loop) {
+            helper.pronounce_batch(sentences, workers);
+        }
+        const auto cost = (lisa::utils::current_ts_us() - start) / loops;
+        const auto seconds = std::max<double>(cost, 1) / 1e6;
+        spdlog::info("Batch, workers: {}, time cost: {} us per pass, {:.0f} sentences/s, speedup: {:.2f}x", workers, cost,
+                     sentences.size() / seconds, sequential / 1e6 / seconds);
+    }
+
+    return 0;
+}
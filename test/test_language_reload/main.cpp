@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "language/language.h"
+#include "model/melo/preprocess.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+namespace fs = std::filesystem;
+
+using lisa::language::LanguageHelper;
+using lisa::language::PronounceId;
+
+static bool same(const std::vector<PronounceId> &lhs, const std::vector<PronounceId> &rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const auto &a, const auto &b) {
+        return a.phone == b.phone && a.tone == b.tone && a.lang == b.lang;
+    });
+}
+
+// Latency of pronounce on reader threads while the lexicon is reloaded over and
+// over, against the same readers with no reload going on. Then edits a word in
+// a copy of the data root, waits for the watcher to swap it in and checks the
+// cached front end of MeloPreprocessor follows.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::info);
+
+    const auto current_path = fs::path(__FILE__).parent_path().string();
+    const std::string source_root = argc > 1 ? argv[1] : current_path + "/../../data/language";
+    const auto data_root = fs::temp_directory_path() / ("lexicon_reload_" + std::to_string(lisa::utils::current_ts_us()));
+    fs::create_directories(data_root);
+    for (const auto &file_name : lisa::language::Lexicon::SOURCE_FILE_NAME_LIST) {
+        fs::copy_file(fs::path(source_root) / file_name, data_root / file_name);
+    }
+    setenv("DOGE_LANGUAGE_DATA_ROOT", data_root.c_str(), 1);
+
+    auto &helper = LanguageHelper::instance();
+    helper.ready().get();
+
+    const std::vector<std::string> sentences = {"银行.", "今天天气很好, 我们一起去公园.", "Hello world, 你好世界.",
+                                                "卡布奇诺和拿铁, 哪个更好喝?"};
+    std::vector<std::vector<PronounceId>> expected(sentences.size());
+    for (auto i = 0U; i < sentences.size(); ++i) {
+        helper.pronounce(sentences[i], expected[i]);
+    }
+    // Cached before the edit, has to be phonemized again after it.
+    const lisa::model::MeloPreprocessor preprocessor;
+    const auto phones_before = preprocessor.preprocess(sentences[0]).at("phones").buffer;
+    const auto hash_before = helper.lexicon_hash();
+
+    const auto reader_count = std::max(2U, std::thread::hardware_concurrency() / 2);
+    const auto measure = [&](const char *name, size_t reloads) {
+        std::atomic<bool> stop{false};
+        std::atomic<size_t> mismatches{0};
+        std::vector<std::vector<uint64_t>> latencies(reader_count);
+        std::vector<std::thread> readers;
+        for (auto r = 0U; r < reader_count; ++r) {
+            readers.emplace_back([&, r] {
+                std::vector<PronounceId> result;
+                for (auto i = r; !stop; ++i) {
+                    const auto index = i % sentences.size();
+                    result.clear();
+                    const auto start = lisa::utils::current_ts_us();
+                    helper.pronounce(sentences[index], result);
+                    latencies[r].push_back(lisa::utils::current_ts_us() - start);
+                    mismatches += same(result, expected[index]) ? 0 : 1;
+                }
+            });
+        }
+        const auto start = lisa::utils::current_ts_us();
+        if (reloads == 0) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+        }
+        for (auto i = 0U; i < reloads; ++i) {
+            helper.reload().get();
+        }
+        const auto cost = lisa::utils::current_ts_us() - start;
+        stop = true;
+        for (auto &reader : readers) {
+            reader.join();
+        }
+
+        std::vector<uint64_t> all;
+        for (const auto &latency : latencies) {
+            all.insert(all.end(), latency.begin(), latency.end());
+        }
+        std::sort(all.begin(), all.end());
+        const auto percentile = [&](double p) { return all.empty() ? 0 : all[static_cast<size_t>(p * (all.size() - 1))]; };
+        spdlog::info("{}, reloads: {} in {} us, calls: {}, mismatches: {}, latency p50: {} us, p99: {} us, max: {} us",
+                     name, reloads, cost, all.size(), mismatches.load(), percentile(0.5), percentile(0.99),
+                     percentile(1.0));
+        return mismatches.load();
+    };
+    auto mismatches = measure("Idle", 0);
+    mismatches += measure("Reloading", 10);
+    // Unchanged sources keep their hash, and so the cached front end, even with a
+    // new modification time as a checkout or copy gives them.
+    const auto words_path = data_root / "chinese_words.pinyin";
+    fs::last_write_time(words_path, fs::last_write_time(words_path) + std::chrono::hours(1));
+    helper.reload().get();
+    const auto kept = helper.lexicon_hash() == hash_before;
+
+    // Edit one word, the watcher has to notice and swap it in without being asked.
+    helper.watch(std::chrono::milliseconds(100));
+    std::stringstream contents;
+    contents << std::ifstream(words_path).rdbuf();
+    auto text = contents.str();
+    const std::string before = "\n银行 yin2 hang2\n";
+    const auto pos = text.find(before);
+    if (pos == std::string::npos) {
+        spdlog::error("Word to edit not found in: {}", words_path.string());
+        return 1;
+    }
+    text.replace(pos, before.size(), "\n银行 yin2 xing2\n");
+    const auto start = lisa::utils::current_ts_us();
+    std::ofstream(words_path) << text;
+
+    auto changed = false;
+    std::vector<PronounceId> result;
+    while (!changed && lisa::utils::current_ts_us() - start < 10000000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        result.clear();
+        helper.pronounce(sentences[0], result);
+        changed = !same(result, expected[0]);
+    }
+    spdlog::info("Edited word {}, time cost: {} us", changed ? "picked up" : "not picked up",
+                 lisa::utils::current_ts_us() - start);
+    helper.watch(std::chrono::milliseconds(0));
+
+    const auto phones_after = preprocessor.preprocess(sentences[0]).at("phones").buffer;
+    const auto refreshed = helper.lexicon_hash() != hash_before && phones_after != phones_before;
+    spdlog::info("Hash kept over unchanged reloads: {}, preprocess follows the edit: {}", kept, refreshed);
+
+    fs::remove_all(data_root);
+    return mismatches == 0 && changed && kept && refreshed ? 0 : 1;
+}
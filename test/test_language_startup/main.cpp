@@ -0,0 +1,48 @@
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#include "cppjieba/Jieba.hpp"
+#include "language/language.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+// Cold start of LanguageHelper against building the full cppjieba::Jieba the
+// helper used to construct, modes "helper", "preload" and "jieba". Run each case
+// in a fresh process for cold caches. Both read the dictionaries under
+// DOGE_CPPJIEBA_DICT_ROOT when it is set.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::debug);
+
+    const std::string mode = argc > 1 ? argv[1] : "helper";
+    if (mode == "jieba") {
+        const auto *env = getenv("DOGE_CPPJIEBA_DICT_ROOT");
+        const auto root = (env != nullptr ? std::string(env)
+                                          : std::filesystem::path(__FILE__).parent_path().string() + "/../../data/cppjieba") +
+                          "/";
+        const auto start = lisa::utils::current_ts_us();
+        cppjieba::Jieba jieba(root + "jieba.dict.utf8", root + "hmm_model.utf8", root + "user.dict.utf8", root + "idf.utf8",
+                              root + "stop_words.utf8");
+        spdlog::info("Full cppjieba startup, time cost: {} us", lisa::utils::current_ts_us() - start);
+        return 0;
+    }
+
+    using Component = lisa::language::LanguageHelper::Component;
+    const auto start = lisa::utils::current_ts_us();
+    if (mode == "preload") {
+        // What a server does at boot: start loading and get on with everything else.
+        const auto ready = lisa::language::LanguageHelper::preload();
+        spdlog::info("LanguageHelper preload returned, time cost: {} us", lisa::utils::current_ts_us() - start);
+        const auto &helper = lisa::language::LanguageHelper::instance();
+        helper.ready(Component::SEGMENTER).get();
+        spdlog::info("LanguageHelper segmenter ready, time cost: {} us", lisa::utils::current_ts_us() - start);
+        helper.ready(Component::LEXICON).get();
+        spdlog::info("LanguageHelper lexicon ready, time cost: {} us", lisa::utils::current_ts_us() - start);
+        ready.get();
+    } else {
+        lisa::language::LanguageHelper::instance().ready().get();
+    }
+    spdlog::info("LanguageHelper startup, time cost: {} us", lisa::utils::current_ts_us() - start);
+
+    return 0;
+}
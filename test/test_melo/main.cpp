@@ -3,9 +3,10 @@
 #include <string>
 
 #include "language/language.h"
+#include "model/melo/executor.h"
 #include "model/melo/preprocess.h"
-#include "openvino/openvino.hpp"
 #include "spdlog/spdlog.h"
+#include "utils/audio.h"
 #include "utils/io.h"
 #include "utils/string.h"
 #include "utils/time.h"
@@ -13,39 +14,52 @@
 int main() {
     spdlog::set_level(spdlog::level::debug);
 
-    ov::Core core;
     const auto current_path = std::filesystem::path(__FILE__).parent_path().string();
     const auto model_path = current_path + "/../../model/melo/melo-zh-en-openvino.xml";
-    ov::CompiledModel compiled_model = core.compile_model(model_path, "AUTO");
-    ov::InferRequest infer_request = compiled_model.create_infer_request();
+    lisa::model::MeloExecutor::Config config;
+    config.performance_hint = "LATENCY";
+    config.cache_dir = current_path + "/../../model/melo/cache";
+    lisa::model::MeloExecutor executor(model_path, config);
 
     std::string text = "Lisa";
     auto preprocesser = lisa::model::MeloPreprocessor();
     auto sentences = preprocesser.split(text, 16);
+    lisa::utils::AudioPostProcessor::Config post_config;
+    post_config.sample_rate = lisa::model::MeloExecutor::SAMPLE_RATE;
+    lisa::utils::AudioPostProcessor post_processor(post_config);
+    std::vector<float> chunk;
     std::vector<float> result;
+    uint64_t post_ns = 0;
 
     for (auto i = 0U; i < sentences.size(); ++i) {
         auto model_input = preprocesser.preprocess(sentences[i], 1.1);
-        auto inputs = compiled_model.inputs();
-        for (const auto &input : inputs) {
-            auto name = *input.get_names().begin();
-            auto data = model_input[name].buffer.data();
-            auto shape = model_input[name].shape;
-            ov::Tensor tensor(input.get_element_type(), shape, data);
-            infer_request.set_tensor(input, tensor);
+        lisa::model::OutputData model_output;
+        if (!executor.infer(model_input, model_output)) {
+            spdlog::error("Infer failed, sentence: [{}]", sentences[i]);
+            return 1;
         }
+        const auto &data = model_output[lisa::model::MeloExecutor::OUTPUT_NAME].buffer;
+        const auto samples = reinterpret_cast<const float *>(data.data());
+        chunk.assign(samples, samples + data.size() / sizeof(float));
+        const auto begin_ns = lisa::utils::current_ts_ns();
+        post_processor.process(chunk, i + 1 == sentences.size());
+        post_ns += lisa::utils::current_ts_ns() - begin_ns;
+        result.insert(result.end(), chunk.begin(), chunk.end());
+    }
 
-        const auto start = lisa::utils::current_ts_ms();
-        infer_request.start_async();
-        infer_request.wait();
-        spdlog::debug("Infer request done, time cost: {} ms", lisa::utils::current_ts_ms() - start);
+    const auto cache_stats = lisa::model::MeloPreprocessor::phoneme_cache_stats();
+    spdlog::debug("Phoneme cache hits: {}, misses: {}, entries: {}, bytes: {}", cache_stats.hits, cache_stats.misses,
+                  cache_stats.entries, cache_stats.bytes);
+
+    const auto begin_ns = lisa::utils::current_ts_ns();
+    std::vector<int16_t> pcm(result.size());
+    uint32_t seed = 0;
+    lisa::utils::float_to_int16(result.data(), result.size(), pcm.data(), seed);
+    post_ns += lisa::utils::current_ts_ns() - begin_ns;
+    spdlog::debug("Post processed {} samples in {} us", result.size(), post_ns / 1000);
 
-        auto outputs = compiled_model.outputs();
-        auto data = infer_request.get_tensor("output");
-        std::copy(data.data<float>(), data.data<float>() + data.get_size(), std::back_inserter(result));
-    }
     const auto save_path = "result.wav";
-    lisa::utils::save_wav(save_path, result.data(), result.size(), 44100, 1);
+    lisa::utils::save_wav(save_path, pcm.data(), pcm.size(), lisa::model::MeloExecutor::SAMPLE_RATE, 1);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model/melo/batcher.h"
+#include "model/melo/executor.h"
+#include "model/melo/preprocess.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+// Stands in for the decoder: four samples per phone, and on the padding a hum
+// that depends on the whole batch, as a real decoder leaves there.
+class FakeExecutor final : public lisa::model::Executor {
+public:
+    explicit FakeExecutor(bool lengths) : lengths_(lengths) {}
+
+    bool infer(const lisa::model::InputData &input, lisa::model::OutputData &output) override {
+        const auto &phones = input.at("phones");
+        const auto batch_size = phones.shape.front();
+        const auto len = phones.shape.back();
+        const auto ids = reinterpret_cast<const int64_t *>(phones.buffer.data());
+        std::vector<float> audio(batch_size * len * 4, 0.001f * batch_size);
+        std::vector<int64_t> lengths;
+        for (auto b = 0U; b < batch_size; ++b) {
+            size_t real = 0;
+            while (real < len && ids[b * len + real] != 0) {
+                ++real;
+            }
+            for (auto i = 0U; i < real * 4; ++i) {
+                audio[b * len * 4 + i] = static_cast<float>(ids[b * len + i / 4]) / (i + 1);
+            }
+            lengths.push_back(static_cast<int64_t>(real * 4));
+        }
+        output[lisa::model::MeloExecutor::OUTPUT_NAME] = to_data(audio, {batch_size, 1, len * 4});
+        if (lengths_) {
+            output[lisa::model::MeloExecutor::LENGTH_OUTPUT_NAME] = to_data(lengths, {batch_size});
+        }
+        return true;
+    }
+
+    template <typename T> static lisa::model::Data to_data(const std::vector<T> &values, lisa::model::DataShape shape) {
+        lisa::model::DataBuffer buffer(values.size() * sizeof(T));
+        std::memcpy(buffer.data(), values.data(), buffer.size());
+        return lisa::model::Data{std::move(buffer), std::move(shape)};
+    }
+
+private:
+    bool lengths_{};
+};
+
+static lisa::model::InputData fake_input(size_t phones) {
+    std::vector<int64_t> ids(phones);
+    for (auto i = 0U; i < phones; ++i) {
+        ids[i] = static_cast<int64_t>(i % 7 + 1);
+    }
+    lisa::model::InputData input;
+    input["phones"] = FakeExecutor::to_data(ids, {1, phones});
+    input[lisa::model::MeloBatcher::SHARED_INPUT_NAME] = FakeExecutor::to_data(std::vector<float>{1.0f}, {1});
+    return input;
+}
+
+// A prompt synthesized alone and batched with a longer one has to come out
+// identical, whether or not the model reports item lengths.
+static bool check_batch_invariance() {
+    for (const auto lengths : {true, false}) {
+        lisa::model::MeloBatcher batcher(std::make_shared<FakeExecutor>(lengths), {2, 200});
+        const auto alone = batcher.submit(fake_input(5)).get();
+        auto short_future = batcher.submit(fake_input(5));
+        auto long_future = batcher.submit(fake_input(13));
+        const auto batched = short_future.get();
+        long_future.get();
+        if (alone.empty() || alone != batched) {
+            spdlog::error("Batched audio differs, lengths reported: {}, alone: {} samples, batched: {} samples", lengths,
+                          alone.size(), batched.size());
+            return false;
+        }
+    }
+    spdlog::info("Batch invariance check passed");
+    return true;
+}
+
+// Synthesizes the same prompts from many concurrent callers, once without
+// batching and once through the batcher, and reports throughput and p99.
+void bench(const std::shared_ptr<lisa::model::MeloExecutor> &executor, const std::vector<lisa::model::InputData> &inputs,
+           const lisa::model::MeloBatcher::Config &config, uint32_t callers) {
+    lisa::model::MeloBatcher batcher(executor, config);
+    std::vector<uint64_t> latencies(inputs.size() * callers);
+
+    const auto start = lisa::utils::current_ts_us();
+    std::vector<std::thread> threads;
+    for (auto c = 0U; c < callers; ++c) {
+        threads.emplace_back([&, c] {
+            for (auto i = 0U; i < inputs.size(); ++i) {
+                const auto begin = lisa::utils::current_ts_us();
+                batcher.submit(inputs[i]).get();
+                latencies[c * inputs.size() + i] = lisa::utils::current_ts_us() - begin;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const auto cost = lisa::utils::current_ts_us() - start;
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto p99 = latencies[latencies.size() * 99 / 100];
+    spdlog::info("max batch size: {}, max delay: {} ms, callers: {}, throughput: {:.2f} sentences/s, p99: {} ms",
+                 config.max_batch_size, config.max_delay_ms, callers, latencies.size() * 1e6 / cost, p99 / 1000);
+}
+
+int main() {
+    spdlog::set_level(spdlog::level::info);
+
+    if (!check_batch_invariance()) {
+        return 1;
+    }
+
+    const auto current_path = std::filesystem::path(__FILE__).parent_path().string();
+    const auto model_path = current_path + "/../../model/melo/melo-zh-en-openvino.xml";
+    static constexpr auto callers = 8U;
+    lisa::model::MeloExecutor::Config config;
+    config.device = "CPU";
+    config.performance_hint = "THROUGHPUT";
+    config.request_count = callers;
+    auto executor = std::make_shared<lisa::model::MeloExecutor>(model_path, config);
+
+    const std::string text = "你好, 请问有什么可以帮您? 好的, 已为您确认. Thank you for calling, goodbye.";
+    auto preprocesser = lisa::model::MeloPreprocessor();
+    std::vector<lisa::model::InputData> inputs;
+    for (const auto &sentence : preprocesser.split(text, 8)) {
+        inputs.push_back(preprocesser.preprocess(sentence, 1.0));
+    }
+
+    bench(executor, inputs, {1, 0}, callers);
+    for (const auto max_batch_size : {2U, 4U, 8U}) {
+        for (const auto max_delay_ms : {5U, 20U}) {
+            bench(executor, inputs, {max_batch_size, max_delay_ms}, callers);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model/melo/executor.h"
+#include "model/melo/preprocess.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+// Sweeps performance hint and stream count on the local CPU. Every infer request
+// gets its own caller thread so throughput settings can actually overlap.
+int main() {
+    spdlog::set_level(spdlog::level::info);
+
+    const auto current_path = std::filesystem::path(__FILE__).parent_path().string();
+    const auto model_path = current_path + "/../../model/melo/melo-zh-en-openvino.xml";
+
+    auto preprocesser = lisa::model::MeloPreprocessor();
+    const auto input = preprocesser.preprocess(preprocesser.split("你好, 请问有什么可以帮您?", 16).front(), 1.0);
+    static constexpr auto rounds = 8U;
+
+    for (const auto hint : {"LATENCY", "THROUGHPUT"}) {
+        for (const auto num_streams : {1, 2, 4}) {
+            lisa::model::MeloExecutor::Config config;
+            config.device = "CPU";
+            config.performance_hint = hint;
+            config.num_streams = num_streams;
+            lisa::model::MeloExecutor executor(model_path, config);
+
+            lisa::model::OutputData warmup;
+            executor.infer(input, warmup);
+
+            const auto callers = executor.request_count();
+            std::vector<uint64_t> latencies(callers, 0);
+            const auto start = lisa::utils::current_ts_us();
+            std::vector<std::thread> threads;
+            for (auto c = 0U; c < callers; ++c) {
+                threads.emplace_back([&, c] {
+                    for (auto i = 0U; i < rounds; ++i) {
+                        lisa::model::OutputData output;
+                        const auto begin = lisa::utils::current_ts_us();
+                        executor.infer(input, output);
+                        latencies[c] += lisa::utils::current_ts_us() - begin;
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            const auto cost = lisa::utils::current_ts_us() - start;
+
+            uint64_t total_latency = 0;
+            for (const auto latency : latencies) {
+                total_latency += latency;
+            }
+            spdlog::info("hint: {}, streams: {}, requests: {}, avg latency: {:.2f} ms, throughput: {:.2f} infer/s", hint,
+                         num_streams, callers, total_latency / 1e3 / (callers * rounds), callers * rounds * 1e6 / cost);
+        }
+    }
+
+    return 0;
+}
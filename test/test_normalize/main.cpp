@@ -0,0 +1,66 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "language/normalize.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+static std::vector<std::string> read_lines(const std::string &path) {
+    std::vector<std::string> lines;
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Checks SentenceNormalizer against the golden output of the original pass by
+// pass implementation, then measures its throughput over the same corpus.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::info);
+
+    const auto current_path = std::filesystem::path(__FILE__).parent_path().string();
+    const std::string root = argc > 1 ? argv[1] : current_path + "/../../data/normalize";
+    const auto corpus = read_lines(root + "/corpus.txt");
+    const auto golden = read_lines(root + "/golden.txt");
+    if (corpus.empty() || corpus.size() != golden.size()) {
+        spdlog::error("Corpus and golden output missing or of different sizes under: {}", root);
+        return 1;
+    }
+
+    size_t mismatches = 0;
+    std::string result;
+    for (auto i = 0U; i < corpus.size(); ++i) {
+        lisa::SentenceNormalizer::normalize(corpus[i], result);
+        if (result != golden[i]) {
+            if (++mismatches <= 10) {
+                spdlog::error("Line {} differs\n  input:    [{}]\n  expected: [{}]\n  actual:   [{}]", i + 1, corpus[i],
+                              golden[i], result);
+            }
+        }
+    }
+    spdlog::info("Equivalence check done, lines: {}, mismatches: {}", corpus.size(), mismatches);
+    if (mismatches != 0) {
+        return 1;
+    }
+
+    size_t bytes = 0;
+    for (const auto &line : corpus) {
+        bytes += line.size();
+    }
+    const auto loops = 50U;
+    const auto start = lisa::utils::current_ts_us();
+    for (auto loop = 0U; loop < loops; ++loop) {
+        for (const auto &line : corpus) {
+            lisa::SentenceNormalizer::normalize(line, result);
+        }
+    }
+    const auto cost = std::max<int64_t>(lisa::utils::current_ts_us() - start, 1);
+    spdlog::info("Normalize throughput: {:.1f} MB/s, {:.2f} us per sentence", bytes * double(loops) / cost,
+                 double(cost) / (loops * corpus.size()));
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "language/number.h"
+#include "reference.h"
+#include "spdlog/spdlog.h"
+#include "utils/string.h"
+#include "utils/time.h"
+
+static std::vector<std::string> read_lines(const std::string &path) {
+    std::vector<std::string> lines;
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static std::wstring verbalize(const std::wstring &number, bool before_year) {
+    std::wstring result;
+    lisa::NumberHelper::number_token_to_chinese(number, before_year, result);
+    return result;
+}
+
+// Checks NumberHelper against the implementation it replaced: every integer
+// below a bound, each in a few token forms, every pattern of zero digits over
+// all four groups, and the normalize corpus sentence by sentence. Then compares
+// their speed on number heavy text.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::info);
+
+    const uint64_t bound = argc > 1 ? std::stoull(argv[1]) : 2000000;
+    const auto current_path = std::filesystem::path(__FILE__).parent_path().string();
+    const std::string corpus_path = argc > 2 ? argv[2] : current_path + "/../../data/normalize/corpus.txt";
+
+    size_t checked = 0;
+    size_t mismatches = 0;
+    const auto check = [&](const std::wstring &number, bool before_year) {
+        ++checked;
+        const auto expected = reference::number_token_to_chinese(number, before_year);
+        const auto actual = verbalize(number, before_year);
+        if (actual != expected && ++mismatches <= 10) {
+            spdlog::error("Number [{}]{} differs\n  expected: [{}]\n  actual:   [{}]", lisa::utils::wstring_to_utf8(number),
+                          before_year ? " before year" : "", lisa::utils::wstring_to_utf8(expected),
+                          lisa::utils::wstring_to_utf8(actual));
+        }
+    };
+
+    auto start = lisa::utils::current_ts_us();
+    for (uint64_t n = 0; n < bound; ++n) {
+        const auto number = std::to_wstring(n);
+        check(number, false);
+        check(number, true);
+        check(L'-' + number, false);
+        check(number + L'%', false);
+        check(L'-' + number + L"%", false);
+        check(L'0' + number, false);
+        check(L'.' + number, false);
+        check(number + L".0" + number, false);
+    }
+    spdlog::info("Integers below {} done, time cost: {} us", bound, lisa::utils::current_ts_us() - start);
+
+    // Which of the 16 digits are zero decides where the '零' go, the other digits
+    // are 1 or 2 for the "十" and "两" rules, or random.
+    start = lisa::utils::current_ts_us();
+    std::mt19937_64 rng(20241019);
+    for (uint32_t zeros = 0; zeros < (1U << 16); ++zeros) {
+        for (auto fill = 0U; fill < 3; ++fill) {
+            std::wstring number(16, L'0');
+            for (auto i = 0U; i < 16; ++i) {
+                if ((zeros >> i & 1) == 0) {
+                    number[i] = fill == 2 ? static_cast<wchar_t>(L'1' + rng() % 9) : static_cast<wchar_t>(L'1' + fill);
+                }
+            }
+            for (auto length = 1U; length <= 16; ++length) {
+                check(number.substr(16 - length), false);
+            }
+        }
+    }
+    spdlog::info("Zero digit patterns done, time cost: {} us", lisa::utils::current_ts_us() - start);
+
+    const auto corpus = read_lines(corpus_path);
+    for (const auto &line : corpus) {
+        const auto sentence = lisa::utils::utf8_to_wstring(line);
+        ++checked;
+        if (lisa::NumberHelper::number_to_chinese(sentence) != reference::number_to_chinese(sentence) &&
+            ++mismatches <= 10) {
+            spdlog::error("Sentence differs: [{}]", line);
+        }
+    }
+    spdlog::info("Equivalence check done, cases: {}, mismatches: {}", checked, mismatches);
+    if (mismatches != 0 || corpus.empty()) {
+        return 1;
+    }
+
+    // Number heavy text: dates, prices, percentages, decimals and long integers.
+    std::vector<std::wstring> sentences;
+    for (auto i = 0U; i < 20000; ++i) {
+        sentences.push_back(std::to_wstring(1900 + rng() % 200) + L"年" + std::to_wstring(1 + rng() % 12) + L"月, 价格" +
+                            std::to_wstring(rng() % 100000) + L"." + std::to_wstring(rng() % 100) + L"元, 上涨" +
+                            std::to_wstring(rng() % 100) + L"%, 温度-" + std::to_wstring(rng() % 40) + L"度, 共" +
+                            std::to_wstring(rng() % 10000000000000ULL) + L"次.");
+    }
+    size_t chars = 0;
+    for (const auto &sentence : sentences) {
+        chars += sentence.size();
+    }
+    const auto loops = 10U;
+    const auto measure = [&](auto &&convert) {
+        const auto begin = lisa::utils::current_ts_us();
+        for (auto loop = 0U; loop < loops; ++loop) {
+            for (const auto &sentence : sentences) {
+                convert(sentence);
+            }
+        }
+        return std::max<int64_t>(lisa::utils::current_ts_us() - begin, 1);
+    };
+    const auto reference_cost = measure(reference::number_to_chinese);
+    const auto cost = measure(lisa::NumberHelper::number_to_chinese);
+    spdlog::info("Number heavy text, sentences: {}, reference: {:.1f} M chars/s, current: {:.1f} M chars/s, speedup: {:.2f}x",
+                 sentences.size(), chars * double(loops) / reference_cost, chars * double(loops) / cost,
+                 double(reference_cost) / cost);
+
+    return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef TEST_TEST_NUMBER_REFERENCE_H_
+#define TEST_TEST_NUMBER_REFERENCE_H_
+
+#include <string>
+
+namespace reference {
+
+std::wstring number_to_chinese(const std::wstring &sentence);
+
+std::wstring number_token_to_chinese(std::wstring number, bool before_year);
+
+} // namespace reference
+
+#endif
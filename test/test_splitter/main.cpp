@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "language/normalize.h"
+#include "language/splitter.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+using lisa::language::StreamSplitter;
+
+// MeloPreprocessor::split before the stream splitter: the whole text normalized,
+// then cut at the first punctuation after min_len bytes.
+static std::vector<std::string> greedy_split(const std::string &text, size_t min_len) {
+    std::string temp;
+    std::vector<std::string> result;
+    for (const auto &c : lisa::SentenceNormalizer::normalize(text)) {
+        if (c == ' ' && temp.empty()) {
+            continue;
+        }
+        temp.push_back(c);
+        if (lisa::SentenceNormalizer::is_supported_punctuation(static_cast<uint8_t>(c)) && temp.size() >= min_len) {
+            result.emplace_back(std::move(temp));
+            temp.clear();
+        }
+    }
+    if (!temp.empty()) {
+        result.emplace_back(std::move(temp));
+    }
+    return result;
+}
+
+static void report(const char *name, const std::vector<std::string> &chunks) {
+    std::vector<double> costs;
+    for (const auto &chunk : chunks) {
+        costs.push_back(static_cast<double>(StreamSplitter::cost(chunk)));
+    }
+    double mean = 0;
+    for (const auto cost : costs) {
+        mean += cost;
+    }
+    mean /= std::max<size_t>(costs.size(), 1);
+    double variance = 0;
+    for (const auto cost : costs) {
+        variance += (cost - mean) * (cost - mean);
+    }
+    const auto deviation = std::sqrt(variance / std::max<size_t>(costs.size(), 1));
+    const auto [min, max] = std::minmax_element(costs.begin(), costs.end());
+    spdlog::info("{}, chunks: {}, cost mean: {:.1f}, stddev: {:.1f}, cv: {:.2f}, min: {}, max: {}", name, chunks.size(),
+                 mean, deviation, deviation / mean, *min, *max);
+}
+
+// Text generated token by token: with eager release every sentence has to come
+// out as soon as the text after it shows it is complete, and numbers and
+// abbreviations cut by a fragment boundary must not end one.
+static unsigned check_fragments() {
+    const char *texts[] = {
+        "Pi is 3.14 today. Next one.",
+        "Dr. Smith arrived. He sat down.",
+        "Visit example.com now! OK?",
+        "价格是3.5元。好的",
+        "他说：“你好。”然后走了。",
+        "J. K. Rowling wrote it. Yes.",
+        "J. R. R. Tolkien wrote it. Yes.",
+        "John F. Kennedy spoke. Yes.",
+        "Take plan B. Then go.",
+        "I got an A. Great.",
+        "e.g. this one. And U.S. that.",
+        "今年是2024年。明年是2025年!",
+        "It costs -1.5%. Fine.",
+    };
+    StreamSplitter::Config config;
+    config.eager = true;
+    const auto split = [&](const std::string &text, std::vector<size_t> cuts, std::vector<size_t> *released) {
+        StreamSplitter splitter(config);
+        std::vector<std::string> chunks;
+        std::string chunk;
+        cuts.push_back(text.size());
+        size_t pos = 0;
+        for (auto i = 0U; i < cuts.size(); ++i) {
+            splitter.push(std::string_view(text).substr(pos, cuts[i] - pos));
+            pos = cuts[i];
+            if (i + 1 == cuts.size()) {
+                splitter.finish();
+            }
+            while (splitter.next(chunk)) {
+                chunks.push_back(chunk);
+                if (released != nullptr) {
+                    released->push_back(pos);
+                }
+            }
+        }
+        return chunks;
+    };
+
+    auto failures = 0U;
+    for (const std::string text : texts) {
+        const auto expected = split(text, {}, nullptr);
+        auto mismatches = 0U;
+        for (size_t i = 0; i <= text.size(); ++i) {
+            for (auto j = i; j <= text.size(); ++j) {
+                mismatches += split(text, {i, j}, nullptr) == expected ? 0 : 1;
+            }
+        }
+        // Byte by byte, when each sentence became available.
+        std::vector<size_t> cuts(text.size());
+        for (size_t i = 0; i < cuts.size(); ++i) {
+            cuts[i] = i;
+        }
+        std::vector<size_t> released;
+        split(text, cuts, &released);
+        std::string released_str;
+        for (auto i = 0U; i < expected.size(); ++i) {
+            released_str += spdlog::fmt_lib::format(" [{}] at byte {}", expected[i], released[i]);
+        }
+        const auto early = expected.size() < 2 || released.front() < text.size();
+        failures += mismatches == 0 && expected.size() == 2 && early ? 0 : 1;
+        spdlog::info("[{}] of {} bytes, fragmentations differing: {}, released:{}", text, text.size(), mismatches,
+                     released_str);
+    }
+    return failures;
+}
+
+// Streams a long document through StreamSplitter in pieces of random size, down
+// to single bytes, and checks the chunks come out as from one push, with the
+// pending text bounded. Then compares chunk cost balance and time to the first
+// chunk with the greedy splitter it replaces.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::info);
+
+    const auto current_path = std::filesystem::path(__FILE__).parent_path().string();
+    const std::string path = argc > 1 ? argv[1] : current_path + "/../../data/normalize/corpus.txt";
+    std::stringstream contents;
+    contents << std::ifstream(path).rdbuf();
+    const auto text = contents.str();
+    if (text.empty()) {
+        spdlog::error("No text in: {}", path);
+        return 1;
+    }
+
+    const StreamSplitter::Config config{};
+    const auto split = [&](size_t max_piece, uint32_t seed, size_t &max_pending) {
+        StreamSplitter splitter(config);
+        std::mt19937 rng(seed);
+        std::vector<std::string> chunks;
+        std::string chunk;
+        max_pending = 0;
+        for (size_t pos = 0; pos < text.size();) {
+            const auto size = std::min<size_t>(1 + rng() % max_piece, text.size() - pos);
+            splitter.push(std::string_view(text).substr(pos, size));
+            pos += size;
+            while (splitter.next(chunk)) {
+                chunks.push_back(chunk);
+            }
+            max_pending = std::max(max_pending, splitter.pending());
+        }
+        splitter.finish();
+        while (splitter.next(chunk)) {
+            chunks.push_back(chunk);
+        }
+        return chunks;
+    };
+
+    auto failures = check_fragments();
+    size_t max_pending = 0;
+    const auto expected = split(text.size(), 0, max_pending);
+    for (const auto max_piece : {1UL, 7UL, 64UL, 4096UL}) {
+        const auto chunks = split(max_piece, static_cast<uint32_t>(max_piece), max_pending);
+        const auto same = chunks == expected;
+        const auto bounded = max_pending <= config.max_pending + max_piece;
+        failures += same && bounded ? 0 : 1;
+        spdlog::info("Pieces up to {} bytes, chunks: {}, same as one push: {}, max pending: {} bytes", max_piece,
+                     chunks.size(), same, max_pending);
+    }
+    const auto over_cap = std::count_if(expected.begin(), expected.end(), [&](const auto &chunk) {
+        return StreamSplitter::cost(chunk) > config.max_cost && chunk.find(' ') != std::string::npos;
+    });
+    failures += over_cap == 0 ? 0 : 1;
+
+    report("Greedy split, 16 bytes", greedy_split(text, 16));
+    report("Stream split", expected);
+
+    auto start = lisa::utils::current_ts_us();
+    const auto greedy = greedy_split(text, 16);
+    const auto greedy_cost = lisa::utils::current_ts_us() - start;
+    start = lisa::utils::current_ts_us();
+    StreamSplitter splitter(config);
+    splitter.push(text);
+    splitter.finish();
+    std::string chunk;
+    splitter.next(chunk);
+    const auto first_cost = lisa::utils::current_ts_us() - start;
+    while (splitter.next(chunk)) {
+    }
+    const auto stream_cost = lisa::utils::current_ts_us() - start;
+    spdlog::info("Document of {} bytes, greedy split: {} us, stream first chunk: {} us, stream all: {} us", text.size(),
+                 greedy_cost, first_cost, stream_cost);
+
+    return failures == 0 ? 0 : 1;
+}
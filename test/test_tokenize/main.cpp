@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cppjieba/MixSegment.hpp"
+#include "language/language.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+using lisa::language::LanguageHelper;
+using lisa::language::Token;
+
+static std::vector<std::string> read_lines(const std::string &path) {
+    std::vector<std::string> lines;
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static bool is_ascii(const std::string &text) {
+    return std::all_of(text.begin(), text.end(), [](char ch) { return static_cast<uint8_t>(ch) < 0x80; });
+}
+
+// The ASCII words of cppjieba dictionaries, the first column of every line.
+static std::unordered_set<std::string> ascii_dictionary_words(const std::vector<std::string> &paths) {
+    std::unordered_set<std::string> words;
+    for (const auto &path : paths) {
+        for (const auto &line : read_lines(path)) {
+            std::string word;
+            std::istringstream(line) >> word;
+            if (!word.empty() && is_ascii(word)) {
+                words.insert(word);
+            }
+        }
+    }
+    return words;
+}
+
+static std::string to_string(const std::vector<Token> &tokens) {
+    std::string result;
+    for (const auto &[word, tag] : tokens) {
+        result += spdlog::fmt_lib::format("({}|{})", word, tag);
+    }
+    return result;
+}
+
+// cppjieba's tag for an ASCII word outside its dictionary.
+static std::string unknown_word_tag(const std::string &word) {
+    const auto half = word.begin() + word.size() / 2;
+    if (half == word.begin()) {
+        return "x";
+    }
+    return std::all_of(word.begin(), half, [](char ch) { return isdigit(static_cast<uint8_t>(ch)) != 0; }) ? "m" : "eng";
+}
+
+// LanguageHelper::tokenize as it was before the ASCII fast path, cppjieba tags
+// the whole sentence.
+static std::vector<Token> reference_tokenize(const cppjieba::MixSegment &segment, const std::string &sentence) {
+    std::vector<Token> result;
+    segment.Tag(sentence, result);
+    for (auto &word : result) {
+        if (word.second == "x" && word.first.size() == 1 && isalpha(word.first[0])) {
+            word.second = "eng";
+        }
+    }
+    if (result.size() >= 3) {
+        std::vector<Token> temp{result.front()};
+        for (auto i = 1U; i < result.size() - 1; ++i) {
+            if (result[i].first == " " && result[i - 1].second == "eng" && result[i + 1].second == "eng") {
+                continue;
+            }
+            temp.emplace_back(result[i]);
+        }
+        temp.emplace_back(result.back());
+        std::swap(temp, result);
+    }
+    return result;
+}
+
+// Whether actual only differs from expected where an ASCII dictionary word got
+// the tag of an unknown word. Tokens have to be cut the same, except for a space
+// between two English words that is dropped now because one of them was only
+// tagged English by that.
+static bool tagged_differently(const std::vector<Token> &expected, const std::vector<Token> &actual,
+                               const std::unordered_set<std::string> &dictionary_words) {
+    const auto retagged = [&](size_t i) {
+        return dictionary_words.count(actual[i].first) != 0 && actual[i].second == unknown_word_tag(actual[i].first);
+    };
+    size_t j = 0;
+    for (size_t i = 0; i < actual.size(); ++i, ++j) {
+        if (j == expected.size() || actual[i].first != expected[j].first) {
+            return false;
+        }
+        if (actual[i].second != expected[j].second && !retagged(i)) {
+            return false;
+        }
+        // The space cppjieba's tag kept between this word and the next.
+        if (i + 1 < actual.size() && j + 2 < expected.size() && expected[j + 1].first == " " &&
+            actual[i + 1].first != " " && actual[i].second == "eng" && actual[i + 1].second == "eng" &&
+            (retagged(i) || retagged(i + 1))) {
+            ++j;
+        }
+    }
+    return j == expected.size();
+}
+
+// Checks tokenize against the cppjieba only path and compares their speed on
+// English, Chinese and code switched sentences. Only ASCII words of the cppjieba
+// dictionaries may come out differently: they are tagged as unknown words now,
+// which may also drop a space next to them. Anything else fails.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::info);
+
+    const auto current_path = std::filesystem::path(__FILE__).parent_path().string();
+    const std::string path = argc > 1 ? argv[1] : current_path + "/../../data/normalize/golden.txt";
+    const std::string dict_root = argc > 2 ? argv[2] : current_path + "/../../data/cppjieba";
+    const auto lines = read_lines(path);
+    if (lines.empty()) {
+        spdlog::error("No sentences in: {}", path);
+        return 1;
+    }
+
+    std::vector<std::string> english, chinese, mixed;
+    for (const auto &line : lines) {
+        const auto ascii = is_ascii(line);
+        const auto letters = std::any_of(line.begin(), line.end(), [](char ch) { return isalpha(static_cast<uint8_t>(ch)); });
+        (ascii ? english : letters ? mixed : chinese).push_back(line);
+    }
+
+    cppjieba::DictTrie dict_trie(dict_root + "/jieba.dict.utf8", dict_root + "/user.dict.utf8");
+    cppjieba::HMMModel hmm_model(dict_root + "/hmm_model.utf8");
+    cppjieba::MixSegment segment(&dict_trie, &hmm_model);
+
+    const auto &helper = LanguageHelper::instance();
+    helper.ready().get();
+
+    const auto dictionary_words = ascii_dictionary_words({dict_root + "/jieba.dict.utf8", dict_root + "/user.dict.utf8"});
+    size_t tag_only = 0;
+    size_t mismatches = 0;
+    for (const auto &line : lines) {
+        const auto expected = reference_tokenize(segment, line);
+        const auto actual = helper.tokenize(line);
+        if (actual == expected) {
+            continue;
+        }
+        if (tagged_differently(expected, actual, dictionary_words)) {
+            ++tag_only;
+            continue;
+        }
+        if (++mismatches <= 10) {
+            spdlog::error("Tokens differ\n  input:    [{}]\n  expected: [{}]\n  actual:   [{}]", line, to_string(expected),
+                          to_string(actual));
+        }
+    }
+    spdlog::info("Equivalence check done, sentences: {}, ASCII dictionary words tagged differently: {}, mismatches: {}",
+                 lines.size(), tag_only, mismatches);
+    if (mismatches != 0) {
+        return 1;
+    }
+
+    const auto loops = 20U;
+    const auto measure = [&](const char *name, const std::vector<std::string> &sentences) {
+        if (sentences.empty()) {
+            return;
+        }
+        auto start = lisa::utils::current_ts_us();
+        for (auto loop = 0U; loop < loops; ++loop) {
+            for (const auto &sentence : sentences) {
+                reference_tokenize(segment, sentence);
+            }
+        }
+        const auto reference = std::max<int64_t>(lisa::utils::current_ts_us() - start, 1);
+        start = lisa::utils::current_ts_us();
+        for (auto loop = 0U; loop < loops; ++loop) {
+            for (const auto &sentence : sentences) {
+                helper.tokenize(sentence);
+            }
+        }
+        const auto current = std::max<int64_t>(lisa::utils::current_ts_us() - start, 1);
+        spdlog::info("{}, sentences: {}, cppjieba only: {} us, tokenize: {} us, speedup: {:.2f}x", name, sentences.size(),
+                     reference / loops, current / loops, static_cast<double>(reference) / current);
+    };
+    measure("English", english);
+    measure("Chinese", chinese);
+    measure("Code switched", mixed);
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <codecvt>
+#include <locale>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "spdlog/spdlog.h"
+#include "utils/string.h"
+#include "utils/time.h"
+
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+// Whether the first malformed sequence of text is a lead byte too close to the
+// end, followed by a byte that is not a continuation byte. codecvt drops it as
+// truncated, it is malformed.
+static bool malformed_tail(const std::string &text) {
+    char32_t ch = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        const auto length = lisa::utils::utf8_sequence(text, pos, ch);
+        if (length == 0) {
+            const auto lead = static_cast<uint8_t>(text[pos]);
+            const auto expected = lead < 0xC2 ? 0U : lead < 0xE0 ? 2U : lead < 0xF0 ? 3U : lead < 0xF5 ? 4U : 0U;
+            return text.size() - pos < expected && std::any_of(text.begin() + pos + 1, text.end(), [](char byte) {
+                       return (static_cast<uint8_t>(byte) & 0xC0) != 0x80;
+                   });
+        }
+        pos += length;
+    }
+    return false;
+}
+
+// The conversions utils used to do, kept as reference for output and speed.
+static std::wstring reference_utf8_to_wstring(const std::string &text) {
+    if (malformed_tail(text)) {
+        throw std::range_error("malformed tail");
+    }
+    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+    return converter.from_bytes(text);
+}
+
+static std::string reference_wstring_to_utf8(const std::wstring &text) {
+    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+    return converter.to_bytes(text);
+}
+
+template <typename From, typename To>
+static bool same_result(To (*reference)(const From &), To (*current)(std::basic_string_view<typename From::value_type>),
+                        const From &input) {
+    To expected;
+    To actual;
+    bool expected_throw = false;
+    bool actual_throw = false;
+    try {
+        expected = reference(input);
+    } catch (const std::range_error &) {
+        expected_throw = true;
+    }
+    try {
+        actual = current(input);
+    } catch (const std::range_error &) {
+        actual_throw = true;
+    }
+    return expected_throw == actual_throw && expected == actual;
+}
+
+static bool check_equivalence(uint32_t rounds) {
+    std::mt19937 rng(42);
+    uint32_t mismatches = 0;
+    uint32_t skipped = 0;
+    for (auto i = 0U; i < rounds; ++i) {
+        // Raw bytes biased towards ASCII and lead bytes, mostly malformed.
+        std::string bytes(rng() % 48, '\0');
+        for (auto &byte : bytes) {
+            const auto r = rng();
+            byte = static_cast<char>(r % 4 == 0 ? 0x80 + r % 0x80 : r % 4 == 1 ? 0xC0 + r % 0x40 : r % 0x80);
+        }
+        // Code points around every encoding boundary, some invalid.
+        static constexpr uint32_t EDGES[] = {
+            0x7F, 0x80, 0x7FF, 0x800, 0xD7FF, 0xD800, 0xDFFF, 0xE000, 0xFFFF, 0x10000, 0x10FFFF, 0x110000,
+        };
+        std::wstring chars(rng() % 48, L'\0');
+        for (auto &ch : chars) {
+            const auto r = rng();
+            ch = static_cast<wchar_t>(r % 8 == 0 ? EDGES[r % std::size(EDGES)] : r % 2 ? r % 0x80 : 0x4E00 + r % 0x5200);
+        }
+        // The reference passes surrogates through both ways, which is not valid UTF-8.
+        const auto has_surrogate = [](const std::wstring &text) {
+            return std::any_of(text.begin(), text.end(), [](wchar_t ch) { return ch >= 0xD800 && ch <= 0xDFFF; });
+        };
+        std::wstring decoded;
+        try {
+            decoded = reference_utf8_to_wstring(bytes);
+        } catch (const std::range_error &) {
+        }
+        if (has_surrogate(decoded) || has_surrogate(chars)) {
+            ++skipped;
+            continue;
+        }
+        if (!same_result<std::string, std::wstring>(reference_utf8_to_wstring, lisa::utils::utf8_to_wstring, bytes) ||
+            !same_result<std::wstring, std::string>(reference_wstring_to_utf8, lisa::utils::wstring_to_utf8, chars)) {
+            ++mismatches;
+        }
+    }
+    spdlog::info("Equivalence check done, rounds: {}, skipped: {}, mismatches: {}", rounds, skipped, mismatches);
+    return mismatches == 0;
+}
+
+// A character split at the end of the text is dropped, a lead byte followed by
+// anything but continuation bytes is malformed.
+static bool check_tails() {
+    const std::pair<std::string, const wchar_t *> cases[] = {
+        {"ab\xE4", L"ab"},         {"ab\xE4\xB8", L"ab"}, {"ab\xF0\x9F\x98", L"ab"},
+        {"ab\xE4" "A", nullptr},   {"ab\xE4\xB8" "A", nullptr}, {"ab\xF0\x9F" "A", nullptr},
+        {"ab\xC3" "A", nullptr},   {"ab\xE4" "\xE4", nullptr},
+    };
+    auto failures = 0U;
+    for (const auto &[input, expected] : cases) {
+        std::wstring result;
+        const auto ok = lisa::utils::utf8_decode(input, result);
+        if (ok != (expected != nullptr) || (ok && result != expected)) {
+            spdlog::error("Tail decoded wrong, input size: {}, ok: {}, chars: {}", input.size(), ok, result.size());
+            ++failures;
+        }
+    }
+    spdlog::info("Tail check done, cases: {}, failures: {}", std::size(cases), failures);
+    return failures == 0;
+}
+
+template <typename Func>
+static void bench(const std::string &name, size_t bytes, uint32_t loops, Func &&func) {
+    const auto start = lisa::utils::current_ts_us();
+    for (auto i = 0U; i < loops; ++i) {
+        func();
+    }
+    const auto cost = std::max<int64_t>(lisa::utils::current_ts_us() - start, 1);
+    spdlog::info("{:<28} {:>8.1f} MB/s, {:>6.2f} us per call", name, bytes * double(loops) / cost, double(cost) / loops);
+}
+
+int main() {
+    spdlog::set_level(spdlog::level::info);
+
+    if (!check_tails() || !check_equivalence(200000)) {
+        return 1;
+    }
+
+    const std::pair<std::string, std::string> corpora[] = {
+        {"ascii", "Hello world, this is a plain ASCII sentence for the TTS front end. "},
+        {"chinese", "今天天气很好，我们一起去公园散步吧。"},
+        {"mixed", "我在用 OpenVINO 跑 MeloTTS，延迟大概 120 ms 左右。"},
+    };
+    for (const auto &[name, sentence] : corpora) {
+        // Short sentences are what the normalizer sees, the long text shows throughput.
+        for (const auto repeat : {1, 64}) {
+            std::string text;
+            for (auto i = 0; i < repeat; ++i) {
+                text += sentence;
+            }
+            const auto wtext = lisa::utils::utf8_to_wstring(text);
+            const auto loops = 200000U / repeat;
+            const auto label = spdlog::fmt_lib::format("{} x{}", name, repeat);
+            size_t sink = 0;
+            bench(label + " decode (codecvt)", text.size(), loops, [&] { sink += reference_utf8_to_wstring(text).size(); });
+            bench(label + " decode", text.size(), loops, [&] { sink += lisa::utils::utf8_to_wstring(text).size(); });
+            bench(label + " encode (codecvt)", text.size(), loops, [&] { sink += reference_wstring_to_utf8(wtext).size(); });
+            bench(label + " encode", text.size(), loops, [&] { sink += lisa::utils::wstring_to_utf8(wtext).size(); });
+            size_t count = 0;
+            bench(label + " iterate", text.size(), loops, [&] {
+                for (const auto ch : lisa::utils::Utf8View(text)) {
+                    count += ch;
+                }
+            });
+            spdlog::debug("sink: {} {}", sink, count);
+        }
+    }
+
+    return 0;
+}
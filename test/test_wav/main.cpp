@@ -0,0 +1,114 @@
+#include <sys/resource.h>
+
+#include <cmath>
+#include <filesystem>
+#include <string>
+
+#include "message/audio_message.h"
+#include "message/message_pool.h"
+#include "spdlog/spdlog.h"
+#include "utils/io.h"
+#include "utils/time.h"
+
+static constexpr uint32_t SAMPLE_RATE = 44100;
+static constexpr size_t CHUNK_FRAMES = 4096;
+
+static long max_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Sample of a sweeping tone, regenerated from its index to check what is read back.
+static float sample_at(uint64_t index) {
+    const auto seconds = double(index) / SAMPLE_RATE;
+    return static_cast<float>(0.8 * std::sin(6.283185307179586 * (200.0 + 20.0 * std::fmod(seconds, 10.0)) * seconds));
+}
+
+// Writes a long recording chunk by chunk from pooled AudioMessage buffers, as
+// float and as 16 bit, follows one while it is written, then reads both back in
+// chunks and checks every sample. Memory has to stay flat however long it is.
+int main(int argc, char *argv[]) {
+    spdlog::set_level(spdlog::level::info);
+
+    const auto minutes = argc > 1 ? std::stod(argv[1]) : 60.0;
+    const auto total_frames = static_cast<uint64_t>(minutes * 60 * SAMPLE_RATE);
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto float_path = (directory / "test_wav_float.wav").string();
+    const auto int16_path = (directory / "test_wav_int16.wav").string();
+
+    lisa::message::MessagePool<lisa::message::AudioMessage> pool(4);
+    const auto rss_begin = max_rss_kb();
+    auto failures = 0U;
+
+    auto start = lisa::utils::current_ts_us();
+    {
+        auto float_writer = lisa::utils::WavWriter::create<float>(float_path, SAMPLE_RATE, 1);
+        auto int16_writer = lisa::utils::WavWriter::create<int16_t>(int16_path, SAMPLE_RATE, 1);
+        if (!float_writer.is_open() || !int16_writer.is_open()) {
+            return 1;
+        }
+        for (uint64_t frame = 0; frame < total_frames; frame += CHUNK_FRAMES) {
+            auto audio_msg = pool.get();
+            audio_msg->channels_ = 1;
+            audio_msg->sample_rate_ = SAMPLE_RATE;
+            audio_msg->data_.resize(std::min<uint64_t>(CHUNK_FRAMES, total_frames - frame));
+            for (size_t i = 0; i < audio_msg->data_.size(); ++i) {
+                audio_msg->data_[i] = sample_at(frame + i);
+            }
+            failures += float_writer.write(audio_msg->samples(), audio_msg->size()) ? 0 : 1;
+            failures += int16_writer.write(audio_msg->samples(), audio_msg->size()) ? 0 : 1;
+
+            // Halfway, a reader opened on the file being written sees what is there so far.
+            if (frame < total_frames / 2 && frame + CHUNK_FRAMES >= total_frames / 2) {
+                float_writer.update_header();
+                lisa::utils::WavReader follower(float_path);
+                failures += follower.frames() == float_writer.frames() ? 0 : 1;
+                spdlog::info("Followed while writing, frames: {} of {}", follower.frames(), float_writer.frames());
+            }
+        }
+        failures += float_writer.frames() == total_frames && int16_writer.frames() == total_frames ? 0 : 1;
+    }
+    spdlog::info("Wrote {:.1f} minutes twice, float: {} MB, int16: {} MB, time cost: {} ms", minutes,
+                 std::filesystem::file_size(float_path) >> 20, std::filesystem::file_size(int16_path) >> 20,
+                 (lisa::utils::current_ts_us() - start) / 1000);
+
+    // 16 bit samples are rounded on the way in and scaled by 1 / 32768 on the way out.
+    for (const auto &[path, tolerance] : {std::pair{float_path, 0.0f}, std::pair{int16_path, 1.5f / 32767}}) {
+        start = lisa::utils::current_ts_us();
+        lisa::utils::WavReader reader(path);
+        if (!reader.is_open() || reader.sample_rate() != SAMPLE_RATE || reader.channels() != 1 ||
+            reader.frames() != total_frames) {
+            spdlog::error("Wrong header: {}", path);
+            return 1;
+        }
+        uint64_t frame = 0;
+        uint64_t first_chunk_us = 0;
+        float error = 0.0f;
+        while (true) {
+            auto audio_msg = pool.get();
+            if (!reader.read(audio_msg->data_, CHUNK_FRAMES)) {
+                break;
+            }
+            if (frame == 0) {
+                first_chunk_us = lisa::utils::current_ts_us() - start;
+            }
+            for (size_t i = 0; i < audio_msg->size(); ++i) {
+                error = std::max(error, std::fabs(audio_msg->samples()[i] - sample_at(frame + i)));
+            }
+            frame += audio_msg->size();
+        }
+        failures += frame == total_frames && error <= tolerance ? 0 : 1;
+        spdlog::info("Read back {}, frames: {}, max error: {:.2e}, first chunk: {} us, time cost: {} ms", path, frame,
+                     error, first_chunk_us, (lisa::utils::current_ts_us() - start) / 1000);
+    }
+
+    std::filesystem::remove(float_path);
+    std::filesystem::remove(int16_path);
+    const auto rss_growth_kb = max_rss_kb() - rss_begin;
+    failures += rss_growth_kb < 16 * 1024 ? 0 : 1;
+    spdlog::info("Peak memory growth: {} KB for {} MB of samples, failures: {}", rss_growth_kb,
+                 total_frames * sizeof(float) >> 20, failures);
+
+    return failures == 0 ? 0 : 1;
+}
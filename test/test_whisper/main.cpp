@@ -4,21 +4,18 @@
 #include <iostream>
 #include <vector>
 
-#include "sndfile.h"
+#include "utils/io.h"
 #include "whisper.h"
 
 int main() {
     std::vector<float> pcmf32;
     constexpr auto wav_path = "result_16000.wav";
-    SF_INFO sfinfo;
-    SNDFILE *sf = sf_open(wav_path, SFM_READ, &sfinfo);
-    if (sf == nullptr) {
+    lisa::utils::WavReader reader(wav_path);
+    if (!reader.is_open()) {
         fprintf(stderr, "failed to open '%s'\n", wav_path);
         return 1;
     }
-    pcmf32.resize(sfinfo.frames * sfinfo.channels);
-    sf_readf_float(sf, pcmf32.data(), pcmf32.size());
-    sf_close(sf);
+    reader.read(pcmf32, reader.frames());
     printf("Read %lu samples\n", pcmf32.size());
     if (pcmf32.size() < 16000) {
         pcmf32.resize(20000);
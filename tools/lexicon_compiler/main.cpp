@@ -0,0 +1,28 @@
+#include <string>
+
+#include "language/lexicon.h"
+#include "spdlog/spdlog.h"
+#include "utils/time.h"
+
+// Compiles the text dictionaries under a language data root into the binary
+// image LanguageHelper maps at startup. Rerun whenever a text source changes,
+// a stale image is detected and ignored at load time.
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        spdlog::error("Usage: {} <language_data_root> [image_path]", argv[0]);
+        return 1;
+    }
+    spdlog::set_level(spdlog::level::debug);
+
+    const std::string data_root = argv[1];
+    const std::string image_path = argc > 2 ? argv[2] : data_root + "/" + lisa::language::Lexicon::IMAGE_FILE_NAME;
+
+    const auto start = lisa::utils::current_ts_ms();
+    if (!lisa::language::Lexicon::save(data_root, image_path)) {
+        spdlog::error("Compile lexicon failed, data root: {}", data_root);
+        return 1;
+    }
+    spdlog::info("Compile lexicon done, image: {}, time cost: {} ms", image_path, lisa::utils::current_ts_ms() - start);
+
+    return 0;
+}